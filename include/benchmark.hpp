@@ -0,0 +1,6 @@
+#pragma once
+
+// Generates the whole map for a few fixed seeds, reports chunks per second and tile memory, and
+// compares the content hash of every chunk against the known good values.
+// Returns 0 if all hashes match. The report is written to "benchmark.txt".
+int run_world_benchmark();
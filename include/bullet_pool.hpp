@@ -0,0 +1,79 @@
+#pragma once
+
+#include <transform.hpp>
+#include <graphics.hpp>
+
+#include <vector>
+
+#define BULLET_NORMAL  0
+#define BULLET_LASER   1
+#define BULLET_BLOOD   2
+#define BULLET_SHOTGUN 3
+#define BULLET_FLAME   4
+
+#define BULLET_OWNER_ENEMY  0
+#define BULLET_OWNER_PLAYER 1
+
+#define BULLET_FLAG_ACTIVE         0x01
+#define BULLET_FLAG_DESTROYS_WALLS 0x02
+#define BULLET_FLAG_HIT_WALL       0x04
+#define BULLET_FLAG_LEFT_WINDOW    0x08
+
+// All bullets in flight, one array per field. The arrays are allocated once, and freed slots
+// are reused through a free list, so viruses and pimples can fire every frame without allocating.
+// Spawns past the capacity are dropped and counted.
+class bullet_pool {
+public:
+
+	static const int default_capacity = 4096;
+
+	std::vector<ne::vector2f> positions;
+	std::vector<ne::vector2f> previous_positions;
+	std::vector<ne::vector2f> sizes;
+	std::vector<ne::vector2f> velocities;
+	std::vector<float> angles;
+	std::vector<uint8> types;
+	std::vector<uint8> owners;
+
+	// BULLET_FLAG_* bits.
+	std::vector<uint8> flags;
+
+	// Set by game_world::trace_bullets(), which follows the whole path moved this frame.
+	std::vector<ne::vector2f> last_centers;
+	std::vector<ne::vector2i> hit_tiles;
+
+	std::vector<ne::sprite_animation> animations;
+
+	int64 overflow_count = 0;
+
+	bullet_pool();
+	bullet_pool(int capacity);
+
+	int capacity() const;
+	int count() const;
+
+	// Slots from 0 to slot_count() - 1 can be active. Others have never been used.
+	int slot_count() const;
+	bool is_active(int slot) const;
+
+	// The slot of the new bullet, or -1 if the pool is full.
+	int spawn(const ne::transform3f& origin, float angle, bool destroy_walls, int type, int owner = BULLET_OWNER_ENEMY, float speed = 6.0f);
+	void despawn(int slot);
+
+	ne::transform3f transform(int slot) const;
+	int attack(int slot) const;
+
+	// Moves the bullets in the slots from first to last - 1 by their velocity, in one pass over
+	// the arrays with SSE2 when available.
+	void update(int first, int last);
+
+	// Draws the bullets of one type with the bound texture, between the previous and current position.
+	void draw(int type, const ne::transform3f& view, float alpha);
+
+private:
+
+	std::vector<int> free_slots;
+	int used_slots = 0;
+	int active_count = 0;
+
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "entity_vector.hpp"
+#include "seeded_random.hpp"
+
+#include <transform.hpp>
+#include <graphics.hpp>
+#include <timer.hpp>
+
+#include <vector>
+
+class game_world;
+
+#define CHASER_KEY_W 0x01
+#define CHASER_KEY_A 0x02
+#define CHASER_KEY_S 0x04
+#define CHASER_KEY_D 0x08
+
+struct chaser_hold {
+	int w = 0;
+	int a = 0;
+	int s = 0;
+	int d = 0;
+};
+
+// Worms and slimes, stored as one array per field instead of one object per enemy.
+// There can be thousands of slimes, and update() only touches the arrays it needs.
+// Same behaviour as the other 8 direction objects, see game_object::update().
+class chaser_store {
+public:
+
+	std::vector<ne::vector2f> positions;
+	std::vector<ne::vector2f> previous_positions;
+	std::vector<ne::vector2f> sizes;
+	std::vector<float> speeds;
+	std::vector<float> max_speeds;
+	std::vector<float> max_speeds_normal;
+	std::vector<float> max_speeds_fast;
+	std::vector<chaser_hold> holds;
+	std::vector<int> hearts;
+	std::vector<int> directions;
+
+	// CHASER_KEY_* bits.
+	std::vector<uint8> keys;
+	std::vector<uint8> previous_keys;
+	std::vector<uint8> collisions;
+
+	// Ticks of the last turn towards the player, and how long to wait after it.
+	std::vector<int64> turn_ticks;
+	std::vector<int64> wait_ticks;
+	std::vector<seeded_random> randoms;
+	std::vector<int64> simulated_ticks;
+	std::vector<ne::timer> immunity_timers;
+	std::vector<ne::sprite_animation> animations;
+
+	// Chasers added since the world last scheduled their first turn.
+	std::vector<entity_handle> added;
+
+	int count() const;
+	int add(const ne::vector2f& position);
+
+	// The last chaser takes the place of the removed one.
+	void remove(int index);
+	void remove_dead();
+	void clear();
+
+	entity_handle handle_at(int index) const;
+	int find(entity_handle handle) const;
+
+	ne::transform3f transform(int index) const;
+
+	void hurt(int index, int damage);
+	bool is_immune(int index) const;
+	bool should_draw(int index) const;
+
+	// Points the chaser towards the player, unless it has to wait. Called by the world when the
+	// chaser asked to be woken, and returns the ticks until the next turn.
+	int64 first_turn(int index);
+	int64 turn(game_world* world, int index);
+
+	// Chasers only change their own state, so ranges can be updated on different threads.
+	// Chasers far from the camera are updated every few ticks, see game_world::simulation_steps().
+	void update(game_world* world, int first, int last);
+
+	// Draws with the bound texture, between the previous and current position.
+	void draw(float alpha);
+
+private:
+
+	handle_table handles;
+	uint64 spawn_count = 0;
+
+	void update_chaser(game_world* world, int index, int steps);
+	void move(game_world* world, int index, uint8 move_keys, float step);
+	void move_left(game_world* world, int index, float speed);
+	void move_right(game_world* world, int index, float speed);
+	void move_up(game_world* world, int index, float speed);
+	void move_down(game_world* world, int index, float speed);
+
+};
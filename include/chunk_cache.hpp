@@ -0,0 +1,41 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <string>
+
+// Region files with a fixed-size record per chunk, read and written through a memory mapping.
+// Loading a chunk is a copy out of the mapped record, there is nothing to decode.
+class chunk_cache {
+public:
+
+	static const int region_size = 32;
+	static const int max_objects = 128;
+
+	chunk_cache() = default;
+	chunk_cache(const chunk_cache&) = delete;
+	~chunk_cache();
+
+	chunk_cache& operator=(const chunk_cache&) = delete;
+
+	// Persistent caches are shared by every run with the seed. Temporary caches get their own
+	// files, which are deleted when closed.
+	void open(uint32 seed, bool persistent);
+	void close();
+
+	bool load(const ne::vector2i& index, chunk_generation& generation);
+	bool store(const chunk_generation& generation);
+
+private:
+
+	struct mapped_region;
+
+	uint32 seed = 0;
+	bool persistent = false;
+	std::string path_prefix;
+	std::vector<mapped_region*> regions;
+
+	mapped_region* region_at(const ne::vector2i& index, bool create);
+	std::string region_path(const ne::vector2i& region) const;
+
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "world.hpp"
+#include "spsc_queue.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Generates requested chunks on a background thread. Only the main thread may call request() and take().
+class chunk_worker {
+public:
+
+	chunk_worker(const world_generator& generator);
+	~chunk_worker();
+
+	bool request(const ne::vector2i& index);
+	std::unique_ptr<chunk_generation> take();
+
+private:
+
+	const world_generator& generator;
+	spsc_queue<ne::vector2i, 64> requests;
+	spsc_queue<chunk_generation*, 16> ready;
+	std::atomic<bool> running{ true };
+	std::thread thread;
+
+	// The thread sleeps while there is nothing to generate or nowhere to put it.
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	bool is_woken = false;
+
+	void run();
+	void notify();
+	void sleep();
+
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <engine.hpp>
+
+#include <vector>
+
+// Refers to an entity for as long as it lives, even while others are removed around it.
+// The generation of a slot changes when its entity is removed, so old handles stop resolving.
+struct entity_handle {
+	uint32 slot = 0;
+	uint32 generation = 0;
+};
+
+// Maps handles to indices in a dense array. Removal is swap-and-pop: the last entity is moved
+// into the hole, so the owner has to do the same move on its own arrays.
+class handle_table {
+public:
+
+	int count() const;
+
+	// The new entity is at index count() - 1.
+	entity_handle add();
+	void remove_at(int index);
+	void clear();
+
+	entity_handle handle_at(int index) const;
+
+	// The index of a live entity, or -1 if it has been removed.
+	int find(entity_handle handle) const;
+
+private:
+
+	struct slot_data {
+		int index = -1;
+		uint32 generation = 1;
+	};
+
+	std::vector<slot_data> slots;
+	std::vector<uint32> free_slots;
+	std::vector<uint32> index_slots;
+
+};
+
+// Entities of one type in a dense array. Removing one is O(1), but changes the order.
+template<typename T>
+class entity_vector {
+public:
+
+	int size() const {
+		return (int)items.size();
+	}
+
+	bool empty() const {
+		return items.empty();
+	}
+
+	T& operator[](int index) {
+		return items[index];
+	}
+
+	const T& operator[](int index) const {
+		return items[index];
+	}
+
+	T& back() {
+		return items.back();
+	}
+
+	typename std::vector<T>::iterator begin() {
+		return items.begin();
+	}
+
+	typename std::vector<T>::iterator end() {
+		return items.end();
+	}
+
+	typename std::vector<T>::const_iterator begin() const {
+		return items.begin();
+	}
+
+	typename std::vector<T>::const_iterator end() const {
+		return items.end();
+	}
+
+	entity_handle push_back(const T& item) {
+		items.push_back(item);
+		return handles.add();
+	}
+
+	// The last entity takes the place of the removed one, so loops have to visit the index again.
+	void remove_at(int index) {
+		if (index != size() - 1) {
+			items[index] = std::move(items.back());
+		}
+		items.pop_back();
+		handles.remove_at(index);
+	}
+
+	template<typename Predicate>
+	void remove_if(Predicate predicate) {
+		for (int i = 0; i < size(); i++) {
+			if (predicate(items[i])) {
+				remove_at(i);
+				i--;
+			}
+		}
+	}
+
+	void clear() {
+		items.clear();
+		handles.clear();
+	}
+
+	entity_handle handle_at(int index) const {
+		return handles.handle_at(index);
+	}
+
+	T* get(entity_handle handle) {
+		int index = handles.find(handle);
+		return index != -1 ? &items[index] : nullptr;
+	}
+
+private:
+
+	std::vector<T> items;
+	handle_table handles;
+
+};
@@ -6,9 +6,17 @@
 #include <camera.hpp>
 #include <ui.hpp>
 
+#include <future>
+
 class game_state : public ne::program_state {
 public:
 
+	// The world is simulated in fixed steps, so it plays the same at any frame rate.
+	// Frames that take too long drop the time past max_ticks_per_update.
+	static const int ticks_per_second = 60;
+	static const uint64 tick_us = 1000000 / ticks_per_second;
+	static const int max_ticks_per_update = 5;
+
 	bool game_over = false;
 	int high_score = 0;
 
@@ -29,13 +37,32 @@ public:
 
 	void save_score();
 	void load_score();
+	void prepare_next_world();
+
+	// Called from stop(), so no world is still being prepared when the engine shuts down.
+	static void discard_next_world();
 
 private:
 
+	// Generated in the background while the game over screen is shown, and adopted by the next game_state.
+	static std::future<prepared_world> next_world;
+
+	static prepared_world take_next_world();
+
 	ne::debug_info debug;
 
 	int key = -1;
 
+	uint64 last_update_ticks = 0;
+	uint64 accumulated_us = 0;
+
+	// How far the current frame is between the last two ticks.
+	float interpolation = 1.0f;
+
+	ne::vector2f previous_camera_position;
+
+	void tick();
+
 };
 
 ne::drawing_shape& still_quad();
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool for splitting loops over entities. Every thread has its own queue of ranges, and
+// threads that run out of work steal from the other end of someone else's queue.
+class job_system {
+public:
+
+	// One thread less than the hardware has, since the calling thread helps out.
+	job_system();
+	job_system(int worker_count);
+	~job_system();
+
+	job_system(const job_system&) = delete;
+	job_system& operator=(const job_system&) = delete;
+
+	// Calls job(first, last) for consecutive ranges of at most grain items, on any thread and
+	// in any order, and returns when all are done. Range n starts at n * grain.
+	void parallel_for(int count, int grain, const std::function<void(int first, int last)>& job);
+
+private:
+
+	struct task {
+		const std::function<void(int, int)>* job = nullptr;
+		int first = 0;
+		int last = 0;
+		std::atomic<int>* remaining = nullptr;
+	};
+
+	struct task_queue {
+		std::mutex mutex;
+		std::deque<task> tasks;
+	};
+
+	// The calling thread owns the first queue.
+	std::vector<std::unique_ptr<task_queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	std::atomic<int> queued_tasks = { 0 };
+	bool is_stopping = false;
+
+	bool take(int queue, task& found);
+	void execute(const task& found);
+	void work(int queue);
+
+};
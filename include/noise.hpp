@@ -0,0 +1,32 @@
+#pragma once
+
+#include <engine.hpp>
+
+// Seeded 2D simplex noise. The block functions fill a whole grid of samples per call,
+// using SSE2 lanes when available, and give the exact same output as the scalar functions.
+class world_noise {
+public:
+
+	void seed(uint32 seed);
+
+	float raw(float x, float y) const;
+	float octave(int octaves, float persistence, float scale, float x, float y) const;
+
+	// Samples every integer coordinate from (x, y) to (x + width - 1, y + height - 1), row by row.
+	void octave_block(float* out, int width, int height, int octaves, float persistence, float scale, int x, int y) const;
+
+	// Raw samples of each octave, one block after the other. Fields that only differ in persistence
+	// can be derived from the same samples with combine_octaves(), with the same result as octave_block().
+	void octave_samples(float* samples, int width, int height, int octaves, float scale, int x, int y) const;
+	static void combine_octaves(float* out, const float* samples, int count, int octaves, float persistence);
+
+private:
+
+	uint8 perm[512];
+	uint8 perm_mod12[512];
+
+	void raw_row(float* out, int count, float frequency, int x, int y) const;
+	void raw_row_scalar(float* out, int count, float frequency, int x, int y) const;
+	void raw_row_sse2(float* out, int count, float frequency, int x, int y) const;
+
+};
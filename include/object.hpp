@@ -12,17 +12,16 @@ class game_world;
 #define MOVE_DIRECTIONS_8    0
 #define MOVE_DIRECTIONS_360  1
 
+// Between two simulation ticks, alpha 0 being the older one.
+inline ne::vector2f interpolate(const ne::vector2f& previous, const ne::vector2f& current, float alpha) {
+	return previous + (current - previous) * alpha;
+}
+
 #define ITEM_PILL         0
 #define ITEM_INJECTION    1
 #define ITEM_SHOTGUN      2
 #define ITEM_FLAMETHROWER 3
 
-#define BULLET_NORMAL  0
-#define BULLET_LASER   1
-#define BULLET_BLOOD   2
-#define BULLET_SHOTGUN 3
-#define BULLET_FLAME   4
-
 class game_object {
 public:
 
@@ -32,6 +31,16 @@ public:
 	int hearts = 1;
 	int immunity_lasts_ms = 1;
 
+	// Where the object was when the tick in previous_tick started. Objects spawned during a tick
+	// have no previous position, and are drawn where they are.
+	ne::vector2f previous_position;
+	int64 previous_tick = -1;
+
+	// Ticks covered by the current update(). More than one far from the camera, where enemies are
+	// updated at a reduced rate and skip their animations and sounds.
+	int simulation_steps = 1;
+	int64 simulated_tick = -1;
+
 	virtual ~game_object() = default;
 
 	virtual void update(game_world* world);
@@ -98,27 +107,6 @@ protected:
 
 };
 
-class bullet_object : public game_object {
-public:
-
-	bool has_hit_wall = false;
-	bool can_destroy_wall = false;
-	bool by_player = false;
-	int type = BULLET_NORMAL;
-
-	bullet_object(const ne::transform3f& origin, float angle, bool destroy_walls, int type);
-
-	void update(game_world* world);
-	void draw();
-
-	int attack() const;
-
-private:
-
-	ne::sprite_animation animation;
-
-};
-
 class enemy_blood_object : public game_object {
 public:
 
@@ -136,45 +124,21 @@ public:
 
 	enemy_pimple_object();
 
-	void update(game_world* world);
+	// Woken by the world on the tick they asked for. Both return the ticks until the next wake.
+	int64 first_wake() const;
+	int64 wake(game_world* world);
+
 	void draw();
 
 private:
 
 	ne::sprite_animation animation;
-	ne::timer timer;
 	bool can_shoot = false;
 	int64 first_reset_ms = 0;
 	int64 interval_ms = 0;
 
 };
 
-class enemy_chaser_object : public game_object {
-public:
-
-	float max_speed_normal = 2.0f;
-	float max_speed_fast = 4.0f;
-
-	struct {
-		int w = 0;
-		int a = 0;
-		int s = 0;
-		int d = 0;
-	} hold;
-
-	enemy_chaser_object();
-
-	void update(game_world* world);
-	void draw();
-
-private:
-
-	ne::sprite_animation animation;
-	ne::timer last_turn;
-	int64 wait_ms = 0;
-
-};
-
 class enemy_slime_queen_object : public game_object {
 public:
 
@@ -183,11 +147,10 @@ public:
 	void update(game_world* world);
 	void draw();
 
-	void explode(game_world* world);
-
-private:
+	int64 first_wake() const;
+	int64 wake(game_world* world);
 
-	ne::timer last_slime_drop;
+	void explode(game_world* world);
 
 };
 
@@ -219,6 +182,7 @@ class artery_object : public game_object {
 public:
 
 	int type = 0;
+	bool is_flipped = false;
 
 	artery_object();
 
@@ -228,22 +192,31 @@ public:
 private:
 
 	ne::sprite_animation animation;
-	bool is_flipped = false;
 
 };
 
 class zindo_blood_object : public game_object {
 public:
 
+	static const int frames = 10;
+	static const int shot_frame = 4;
+
+	// The animation runs on the tick clock from this tick, and the shot leaves on its shot frame.
+	int64 spawn_tick = 0;
+
 	zindo_blood_object();
 
-	void update(game_world* world);
+	int64 first_wake() const;
+	int64 wake(game_world* world);
+
+	// Shows the frame of the animation at the tick.
+	void animate(int64 tick);
 	void draw();
 
 private:
 
 	ne::sprite_animation animation;
-	ne::timer last_shot;
+	int64 frame_ticks = 1;
 
 };
 
@@ -255,12 +228,14 @@ public:
 	void update(game_world* world);
 	void draw();
 
+	int64 first_wake() const;
+	int64 wake(game_world* world);
+
 private:
 
 	ne::sprite_animation animation;
 	float angle = 0.0f;
-	ne::timer waiter;
-	ne::timer made_sound;
+	bool is_awake = false;
 
 };
 
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <engine.hpp>
+#include <transform.hpp>
+
+// Small random generator with its own state (splitmix64). Chunks and chasers each have one,
+// so their numbers do not depend on the order or thread they are handled in.
+class seeded_random {
+public:
+
+	seeded_random(uint64 seed);
+	seeded_random(uint32 world_seed, const ne::vector2i& index);
+
+	uint32 next();
+	float next_float();
+	bool chance(float percent);
+	int next_int(int max);
+
+private:
+
+	uint64 state = 0;
+
+};
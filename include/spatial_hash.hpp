@@ -0,0 +1,41 @@
+#pragma once
+
+#include <transform.hpp>
+
+#include <vector>
+
+// Broadphase for box queries. Boxes are sorted into hashed grid cells with a counting sort,
+// so a query only visits the boxes in the cells it overlaps. Meant to be rebuilt every frame.
+class spatial_hash {
+public:
+
+	static const int cell_size = 64;
+	static const int bucket_count = 4096;
+
+	struct entry {
+		int type = 0;
+		int index = 0;
+	};
+
+	void clear();
+	void add(int type, int index, const ne::transform3f& transform);
+	void build();
+
+	// Entries in the cells the box overlaps. Can contain duplicates, and boxes that do not overlap.
+	void query(const ne::transform3f& transform, std::vector<entry>& found) const;
+
+private:
+
+	struct added_entry {
+		int bucket = 0;
+		entry item;
+	};
+
+	std::vector<added_entry> added;
+	std::vector<entry> entries;
+	std::vector<int> bucket_start;
+
+	static int bucket_at(int x, int y);
+	static void cell_range(const ne::transform3f& transform, int& first_x, int& first_y, int& last_x, int& last_y);
+
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free queue for exactly one producer thread and one consumer thread.
+template<typename T, size_t Capacity>
+class spsc_queue {
+public:
+
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	bool push(const T& item) {
+		size_t tail = write.load(std::memory_order_relaxed);
+		if (tail - read.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+		items[tail & (Capacity - 1)] = item;
+		write.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& item) {
+		size_t head = read.load(std::memory_order_relaxed);
+		if (head == write.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = items[head & (Capacity - 1)];
+		read.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+
+	T items[Capacity];
+	alignas(64) std::atomic<size_t> read{ 0 };
+	alignas(64) std::atomic<size_t> write{ 0 };
+
+};
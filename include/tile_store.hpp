@@ -0,0 +1,52 @@
+#pragma once
+
+#include <engine.hpp>
+
+#include <vector>
+
+struct tile_data {
+	int8 type = 0;
+	int8 extra = -1;
+	int8 health = 1;
+};
+
+// The tiles of one chunk, stored as compactly as their content allows. Chunks with a single
+// tile value only store that value, others store palette indices packed into 1, 2, 4 or 8 bits.
+// A chunk is expanded to the full array the first time one of its tiles is written.
+class tile_store {
+public:
+
+	static const int total_tiles = 32 * 32;
+
+	// Compresses a full array of tiles.
+	void assign(const tile_data* tiles);
+	void copy_to(tile_data* tiles) const;
+	void clear();
+
+	const tile_data& get(int i) const {
+		if (!full.empty()) {
+			return full[i];
+		}
+		if (bits == 0) {
+			return palette[0];
+		}
+		int bit = i * bits;
+		uint64 mask = (1ull << bits) - 1;
+		return palette[(size_t)((packed[bit / 64] >> (bit % 64)) & mask)];
+	}
+
+	tile_data* edit(int i);
+
+	bool is_uniform() const;
+
+	// Bytes allocated for the tiles.
+	size_t memory_size() const;
+
+private:
+
+	std::vector<tile_data> palette = { tile_data{} };
+	std::vector<uint64> packed;
+	std::vector<tile_data> full;
+	int bits = 0;
+
+};
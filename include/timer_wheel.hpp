@@ -0,0 +1,83 @@
+#pragma once
+
+#include <engine.hpp>
+
+#include <vector>
+
+// Holds values until the tick they are due, without looking at the waiting ones every tick.
+// The first level has one slot per tick. Each level above has slots as long as the whole level
+// below, and a slot is spread out over the level below when the clock reaches it. Timers further
+// ahead than the top level wait in a list, which is only looked at when the top level wraps.
+template<typename T>
+class timer_wheel {
+public:
+
+	static const int slot_bits = 6;
+	static const int slots = 1 << slot_bits;
+	static const int levels = 4;
+
+	// Due on the given tick, or on the next one if that has already been.
+	void schedule(int64 due, const T& value) {
+		if (due <= current) {
+			due = current + 1;
+		}
+		place({ due, value });
+	}
+
+	// Runs the clock up to the tick, and appends the values that were due, in order of their tick.
+	// Values due on the same tick are in no particular order, though always the same one for the
+	// same calls to schedule().
+	void advance(int64 tick, std::vector<T>& due) {
+		while (current < tick) {
+			current++;
+			// From the top down, so timers moved down a level are moved on if their slot is next.
+			if ((current & ((1ll << (levels * slot_bits)) - 1)) == 0) {
+				cascade(far_timers);
+			}
+			for (int level = levels - 1; level > 0; level--) {
+				int shift = level * slot_bits;
+				if ((current & ((1ll << shift) - 1)) == 0) {
+					cascade(wheel[level][(current >> shift) & (slots - 1)]);
+				}
+			}
+			std::vector<timer>& fired = wheel[0][current & (slots - 1)];
+			for (auto& timer : fired) {
+				due.push_back(timer.value);
+			}
+			fired.clear();
+		}
+	}
+
+private:
+
+	struct timer {
+		int64 due = 0;
+		T value;
+	};
+
+	std::vector<timer> wheel[levels][slots];
+	std::vector<timer> far_timers;
+	std::vector<timer> moving;
+	int64 current = 0;
+
+	void place(const timer& timer) {
+		int64 ahead = timer.due - current;
+		for (int level = 0; level < levels; level++) {
+			int shift = level * slot_bits;
+			if (ahead < (1ll << (shift + slot_bits))) {
+				wheel[level][(timer.due >> shift) & (slots - 1)].push_back(timer);
+				return;
+			}
+		}
+		far_timers.push_back(timer);
+	}
+
+	void cascade(std::vector<timer>& timers) {
+		moving.swap(timers);
+		for (auto& timer : moving) {
+			place(timer);
+		}
+		moving.clear();
+	}
+
+};
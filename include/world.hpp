@@ -1,14 +1,24 @@
 #pragma once
 
 #include "player.hpp"
+#include "noise.hpp"
+#include "seeded_random.hpp"
+#include "tile_store.hpp"
+#include "spatial_hash.hpp"
+#include "chaser_store.hpp"
+#include "bullet_pool.hpp"
+#include "timer_wheel.hpp"
 
 #include <graphics.hpp>
 #include <engine.hpp>
 
+#include <memory>
+
 #define TILE_BG_BOTTOM  0
 #define TILE_BG_TOP     1
 #define TILE_WALL       2
 #define TILE_SLIME      3
+#define TILE_NONE      -1
 
 #define TILE_EX_BONE_BASE_LEFT    0
 #define TILE_EX_BONE_BASE_RIGHT   1
@@ -19,29 +29,50 @@
 #define TILE_EX_BONE_TOP_LEFT     6
 #define TILE_EX_BONE_TOP_RIGHT    7
 
+#define HALO_UP     0
+#define HALO_DOWN   1
+#define HALO_LEFT   2
+#define HALO_RIGHT  3
+
+// Bullets hit the first target in this order.
+#define HIT_WORM         0
+#define HIT_SLIME        1
+#define HIT_SLIME_QUEEN  2
+#define HIT_VIRUS        3
+#define HIT_ZINDO_BLOOD  4
+#define HIT_ARTERY       5
+#define HIT_PIMPLE       6
+#define HIT_NEURON       7
+#define HIT_BLOOD        8
+#define HIT_SPIKE        9
+#define HIT_EYE_BOSS     10
+#define HIT_TYPES        11
+
+#define HIT_EVENT_TARGET       0
+#define HIT_EVENT_PLAYER       1
+#define HIT_EVENT_WALL         2
+#define HIT_EVENT_LEFT_WINDOW  3
+
+#define WAKE_PIMPLE       0
+#define WAKE_ZINDO_BLOOD  1
+#define WAKE_SLIME_QUEEN  2
+#define WAKE_VIRUS        3
+#define WAKE_WORM         4
+#define WAKE_SLIME        5
+
+#define PLACED_PIMPLE       0
+#define PLACED_ARTERY       1
+#define PLACED_ZINDO_BLOOD  2
+#define PLACED_NEURON       3
+#define PLACED_SPIKE        4
+
 class player_object;
 class game_world;
 class game_state;
 class world_chunk;
-
-class world_generator {
-public:
-
-	void normal(const ne::vector2i& index);
-	void border(const ne::vector2i& index);
-
-	bool add_bone(world_chunk& chunk, int i);
-	bool add_spike(world_chunk& chunk, int i);
-
-	game_world* world = nullptr;
-
-};
-
-struct tile_data {
-	int8 type = 0;
-	int8 extra = -1;
-	int8 health = 1;
-};
+class chunk_worker;
+class chunk_cache;
+class job_system;
 
 struct slime_tile_data {
 	int i = -1;
@@ -55,7 +86,9 @@ class world_chunk {
 public:
 
 	static const int tile_pixel_size = 16;
+	static const int tile_pixel_shift = 4;
 	static const int tiles_per_row = 32;
+	static const int tiles_per_row_shift = 5;
 	static const int tiles_per_column = 32;
 	static const int total_tiles = tiles_per_row * tiles_per_column;
 	static const int pixel_width = tiles_per_row * tile_pixel_size;
@@ -63,74 +96,317 @@ public:
 
 	static const bool offset_to_grid = false;
 
+	static ne::vector2f origin(const ne::vector2i& index);
+
 	game_world* world = nullptr;
 	ne::transform3f transform;
 	ne::vector2i index;
+	bool is_resident = false;
+	bool is_generated = false;
+	bool is_requested = false;
+	bool is_modified = false; // Differs from the generated chunk, so it is written back on eviction.
 	bool needs_rendering = true;
 	ne::drawing_shape shape;
 
-	tile_data tiles[total_tiles];
+	tile_store tiles;
 	std::vector<slime_tile_data> slime_tiles;
 
-	tile_data* at(int x, int y);
+	// Objects placed by the generator. They are kept with their chunk, and unloaded with it.
+	entity_vector<enemy_pimple_object> pimple_enemies;
+	entity_vector<artery_object> arteries;
+	entity_vector<zindo_blood_object> zindo_bloods;
+	entity_vector<neuron_object> neurons;
+	entity_vector<spike_object> spikes;
+
+	// Copies of the edge tiles of the four neighbours, so lookups one tile outside the chunk
+	// are array reads. Tiles of neighbours that are not generated have the type TILE_NONE.
+	// Kept up to date when tiles are destroyed, not on every hit, so the health can be stale.
+	tile_data halo[4][tiles_per_row];
+
+	// Works one tile outside the chunk, except for the corners.
+	const tile_data* at(int x, int y) const;
+	const tile_data& edge_tile(int side, int i) const;
+	void copy_halo(int side, const world_chunk* neighbour);
 	void render_tile(int type);
 	void render_tile_ex(int from, int to);
 	void render();
-	std::pair<tile_data*, ne::vector2i> tile_at_world_position(const ne::vector2f& position);
+	std::pair<const tile_data*, ne::vector2i> tile_at_world_position(const ne::vector2f& position);
 
 	world_chunk();
 
 	void set_index(const ne::vector2i& index);
+	void load(const ne::vector2i& index);
+	void unload();
 	void draw_tiles();
 	void draw_slime();
 
 };
 
+static_assert(world_chunk::total_tiles == tile_store::total_tiles, "Chunk and tile store sizes differ");
+static_assert(1 << world_chunk::tile_pixel_shift == world_chunk::tile_pixel_size, "Tile size must match its shift");
+static_assert(1 << world_chunk::tiles_per_row_shift == world_chunk::tiles_per_row, "Chunk size must match its shift");
+static_assert(world_chunk::tiles_per_row == world_chunk::tiles_per_column, "Chunks must be square");
+static_assert(world_chunk::tiles_per_row == 32, "Solidity bitmap rows are filled 32 bits at a time");
+
+// Walls, slime and the lower parts of bones block movement.
+bool is_solid_tile(const tile_data& tile);
+
+struct placed_object {
+	int type = PLACED_PIMPLE;
+	ne::vector2f position;
+	int variant = 0;
+	bool flipped = false;
+};
+
+// Everything the generator produces for one chunk. Merged into the world on the main thread.
+struct chunk_generation {
+	ne::vector2i index;
+	tile_data tiles[world_chunk::total_tiles];
+	std::vector<int> slime_tiles;
+	std::vector<placed_object> objects;
+
+	uint64 content_hash() const;
+};
+
+// The noise fields a chunk is carved from. Fields sampled at the same coordinates share raw octaves.
+struct chunk_noise {
+	float cave[world_chunk::total_tiles];
+	float floor[world_chunk::total_tiles];
+	float pillars[world_chunk::total_tiles];
+	float slime[world_chunk::total_tiles];
+	float octaves[4 * world_chunk::total_tiles];
+};
+
+class world_generator {
+public:
+
+	// Stored with cached chunks, which are only loaded by the same version of the generator.
+	// Increase it whenever the generated chunks change.
+	static const uint32 version = 1;
+
+	uint32 seed = 0;
+	world_noise noise;
+
+	// Size of the world in chunks. The outermost chunks are walls. Zero means the axis is unbounded.
+	ne::vector2i size = { 32, 32 };
+
+	void set_seed(uint32 seed);
+
+	bool is_border(const ne::vector2i& index) const;
+
+	void generate(const ne::vector2i& index, chunk_generation& generation) const;
+	void generate(const std::vector<ne::vector2i>& indices, std::vector<chunk_generation>& generations, job_system& jobs) const;
+
+	void fill_noise(const ne::vector2i& index, chunk_noise& fields) const;
+	void normal(chunk_generation& generation) const;
+	void border(chunk_generation& generation) const;
+
+	bool add_bone(chunk_generation& generation, int i, seeded_random& random) const;
+	bool add_spike(chunk_generation& generation, int i, seeded_random& random) const;
+
+};
+
+// First tile along a segment that stops bullets.
+struct ray_hit {
+	bool is_blocked = false;
+	bool has_left_window = false; // Or entered a chunk that is not generated yet.
+	ne::vector2i tile; // In world tile coordinates.
+};
+
+// Something a bullet ran into this frame. A bullet can have several target events, in the order
+// they are tried, followed by at most one player, wall or window event.
+struct hit_event {
+	int bullet = 0;
+	int kind = HIT_EVENT_TARGET;
+	spatial_hash::entry target;
+	int damage = 0;
+};
+
+// An entity that asked to be woken on a later tick. Placed objects also need the slot of their chunk.
+struct wake_call {
+	int type = WAKE_PIMPLE;
+	int chunk = -1;
+	entity_handle target;
+};
+
+// The start area of a world, generated before the world itself is created.
+struct prepared_world {
+	uint32 seed = 0;
+	ne::vector2i size = { 32, 32 };
+	std::vector<chunk_generation> chunks;
+};
+
 class game_world {
 public:
 
-	static const int chunks_per_row = 32;
-	static const int chunks_per_column = 32;
-	static const int total_chunks = chunks_per_row * chunks_per_column;
+	// Only a window of chunks around the player is kept in memory.
+	static const int window_size = 8;
+	static const int resident_chunks = window_size * window_size;
+	static_assert((window_size & (window_size - 1)) == 0, "The window is wrapped with a mask");
+	static const int stream_radius = 2;
+	static const int stream_lookahead_frames = 60;
+
+	// Enemies further than these margins outside the camera view are updated every second or
+	// every fourth tick instead, with longer steps.
+	static const int full_rate_margin = 64;
+	static const int half_rate_margin = 192;
+	static const int max_simulation_interval = 4;
+
+	// Placed objects are only updated, hit and drawn in the chunks next to the player's, and in
+	// those within this margin of the camera view. Elsewhere they wait in their chunk.
+	static const int placed_object_margin = 64;
+
+	// One bit per tile in the window, set for solid tiles. Indexed by world tile coordinates wrapped
+	// to the grid, so each chunk slot owns a fixed block. Bits of chunks that are not generated are clear.
+	static const int solidity_size = window_size * world_chunk::tiles_per_row;
+	static const int solidity_words = solidity_size / 64;
 
 	game_state* game = nullptr;
 
-	world_chunk chunks[total_chunks];
+	world_chunk chunks[resident_chunks];
 
 	player_object player;
-	std::vector<enemy_blood_object> blood_enemies;
-	std::vector<enemy_pimple_object> pimple_enemies;
-	std::vector<enemy_chaser_object> worm_enemies;
-	std::vector<enemy_chaser_object> slime_enemies;
-	std::vector<enemy_slime_queen_object> slime_queens;
-	std::vector<bullet_object> bullets;
-	std::vector<item_object> pills;
-	std::vector<item_object> injections;
-	std::vector<item_object> shotguns;
-	std::vector<item_object> flamethrowers;
-	std::vector<spike_object> spikes;
-	std::vector<artery_object> arteries;
-	std::vector<zindo_blood_object> zindo_bloods;
-	std::vector<virus_object> viruses;
-	std::vector<neuron_object> neurons;
-	std::vector<eye_boss_object> eye_bosses;
+	entity_vector<enemy_blood_object> blood_enemies;
+	chaser_store worm_enemies;
+	chaser_store slime_enemies;
+	entity_vector<enemy_slime_queen_object> slime_queens;
+	bullet_pool bullets;
+	entity_vector<item_object> pills;
+	entity_vector<item_object> injections;
+	entity_vector<item_object> shotguns;
+	entity_vector<item_object> flamethrowers;
+	entity_vector<virus_object> viruses;
+	entity_vector<eye_boss_object> eye_bosses;
+
+	int64 generation_budget_us = 2000;
+
+	// Counts calls to update(), which are fixed simulation steps.
+	int64 tick = 0;
+
+	// Timers are counted in ticks, so they play out the same no matter how long a tick takes.
+	static int64 ticks_from_ms(int64 ms);
 
 	game_world();
+	game_world(uint32 seed);
+	// Bullets fired past the capacity are dropped, and counted in bullets.overflow_count.
+	game_world(uint32 seed, const ne::vector2i& size, int bullet_capacity = bullet_pool::default_capacity);
+	game_world(const prepared_world& prepared, int bullet_capacity = bullet_pool::default_capacity);
+	~game_world();
+
+	// Pure generation work, so it can run on any thread.
+	static prepared_world prepare(uint32 seed, const ne::vector2i& size);
 
-	void update_items(std::vector<item_object>& items, int type, int max_of);
+	uint32 seed() const;
+
+	void update_items(entity_vector<item_object>& items, int type, int max_of);
 
 	void spawn_objects(world_chunk& chunk);
+	void generate(world_chunk& chunk);
+	void generate(const std::vector<world_chunk*>& chunks);
+	void apply(const chunk_generation& generation);
+	void stream_chunks();
+	void center_window(const ne::vector2i& index);
+	void evict(world_chunk& chunk);
+	void write_back(world_chunk& chunk);
+	bool load_cached(const ne::vector2i& index, chunk_generation& generation);
+	void mark_modified(const ne::vector2i& index);
+	void request_chunks_around(const ne::vector2i& index);
 
 	void update();
-	void draw(const ne::transform3f& view);
 
+	// Entities are woken ticks from now, at the earliest on the next tick, if they are still alive by then.
+	void wake_after(int64 ticks, const wake_call& call);
+	void wake_due();
+
+	// Ticks between updates of an enemy at this position, 1 when it is near the camera view.
+	int simulation_interval(const ne::vector2f& position) const;
+
+	// How many ticks to simulate the enemy for now, or 0 if it sits this tick out. The phase,
+	// usually its index, spreads the updates of enemies that were spawned together over the ticks.
+	int simulation_steps(const ne::vector2f& position, int phase, int64& simulated_tick) const;
+	bool is_simulated_now(game_object& object, int phase) const;
+
+	// Draws the objects between where they were before and after the last tick.
+	void draw(const ne::transform3f& view, float alpha);
+
+	bool is_inside_world(int x, int y) const;
+	bool is_inside_window(int x, int y) const;
+	world_chunk* slot(int x, int y);
 	world_chunk* at(int x, int y);
+	ne::vector2i chunk_index_at_world_position(const ne::vector2f& position) const;
 	world_chunk* chunk_at_world_position(const ne::vector2f& position);
 	std::vector<world_chunk*> neighbour_chunks(int x, int y);
 
-	bool is_free_at(const ne::vector2f& position);
+	// Never generates, so jobs can call it. Chunks that are not generated yet are solid.
+	bool is_free_at(const ne::vector2f& position) const;
+	bool is_area_free(const ne::vector2f& position, const ne::vector2f& size);
+	bool find_free_tile(world_chunk& chunk, ne::vector2f& position);
+	ray_hit trace(const ne::vector2f& from, const ne::vector2f& to) const;
+	void trace_bullets();
+
+	void build_hit_grid();
+	chaser_store* hit_chasers(int type);
+	game_object& hit_target(const spatial_hash::entry& entry);
+	int target_hearts(const spatial_hash::entry& entry);
+	ne::transform3f target_transform(const spatial_hash::entry& entry);
+
+	// Only reads the world, and fills the events of the bullets from first to last - 1.
+	void detect_bullet_hits(int first, int last, std::vector<spatial_hash::entry>& candidates, std::vector<hit_event>& events);
+	void resolve_bullet_hits(const std::vector<hit_event>& events);
+	bool resolve_target_hit(const hit_event& event);
+	bool resolve_wall_hit(const hit_event& event);
+	void drop_item(int type, const ne::vector2f& position);
+	void remove_dead_targets();
+	void link_halo(world_chunk& chunk);
+	void unlink_halo(world_chunk& chunk);
+	void update_halo_tile(world_chunk& chunk, int i);
+	void store_previous_positions();
+	void interpolate_positions(float alpha);
+	void restore_positions();
+	void fill_solidity(const world_chunk& chunk);
+	void set_solidity(const world_chunk& chunk, int i);
 
 	world_generator generator;
 
+private:
+
+	// Worlds with an explicit seed keep their cache files, so the next run can load the same chunks.
+	game_world(uint32 seed, const ne::vector2i& size, bool keep_cache, const std::vector<chunk_generation>& prepared, int bullet_capacity);
+
+	std::unique_ptr<chunk_worker> worker;
+	// Generated chunks, only for worlds that keep their cache files. Never holds damaged chunks,
+	// so every run of a seed starts from the same world.
+	std::unique_ptr<chunk_cache> cache;
+	// Chunks damaged in this session, written back when they are evicted. Always temporary.
+	std::unique_ptr<chunk_cache> damaged_chunks;
+	std::unique_ptr<job_system> jobs;
+	uint64 solidity[solidity_size * solidity_words];
+	spatial_hash hit_grid;
+	std::vector<spatial_hash::entry> hit_candidates;
+	std::vector<hit_event> hit_events;
+	std::vector<std::vector<spatial_hash::entry>> job_hit_candidates;
+	std::vector<std::vector<hit_event>> job_hit_events;
+	timer_wheel<wake_call> wakes;
+	std::vector<wake_call> due_wakes;
+	std::vector<ne::vector2f> simulated_positions;
+
+	int slot_index(int x, int y) const;
+	bool is_generated_in_window(int x, int y) const;
+	bool is_row_solid(int row, int from, int to) const;
+	ne::vector2f last_player_position;
+	ne::transform3f simulation_view;
+
+	ne::vector2i first_active_chunk;
+	ne::vector2i last_active_chunk;
+
+	template<typename Function>
+	void for_each_object_list(Function function);
+
+	// Calls function(chunk) for the generated chunks from first to last, without loading any.
+	template<typename Function>
+	void for_each_generated_chunk(const ne::vector2i& first, const ne::vector2i& last, Function function);
+	void find_active_chunks();
+	ne::vector2i window_origin;
+
 };
 
@@ -0,0 +1,106 @@
+#include "benchmark.hpp"
+#include "world.hpp"
+#include "chunk_cache.hpp"
+#include "tile_store.hpp"
+#include "job_system.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+struct world_benchmark_case {
+	uint32 seed;
+	uint64 expected_hash;
+};
+
+// Update these only when the generated world is meant to change, along with world_generator::version.
+static const world_benchmark_case benchmark_cases[] = {
+	{ 1, 0x9300f3ebba4672e9ull },
+	{ 1337, 0x0e27339e1a7899f4ull },
+	{ 20180421, 0x0b1aaab7e4d780f8ull }
+};
+
+static uint64 combine_hashes(const std::vector<chunk_generation>& generations) {
+	uint64 hash = 14695981039346656037ull;
+	for (auto& generation : generations) {
+		hash = (hash ^ generation.content_hash()) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int run_world_benchmark() {
+	std::ofstream out("benchmark.txt");
+	world_generator generator;
+	job_system jobs;
+	std::vector<ne::vector2i> indices;
+	for (int y = 0; y < generator.size.y; y++) {
+		for (int x = 0; x < generator.size.x; x++) {
+			indices.push_back({ x, y });
+		}
+	}
+	int failures = 0;
+	for (auto& test : benchmark_cases) {
+		generator.set_seed(test.seed);
+
+		std::vector<chunk_generation> serial(indices.size());
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < indices.size(); i++) {
+			generator.generate(indices[i], serial[i]);
+		}
+		double serial_seconds = seconds_since(start);
+
+		std::vector<chunk_generation> parallel;
+		start = std::chrono::steady_clock::now();
+		generator.generate(indices, parallel, jobs);
+		double parallel_seconds = seconds_since(start);
+
+		// Round trip through a temporary cache, which must give back the same chunks.
+		chunk_cache cache;
+		cache.open(test.seed, false);
+		for (auto& generation : serial) {
+			cache.store(generation);
+		}
+		std::vector<chunk_generation> cached(indices.size());
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < indices.size(); i++) {
+			cache.load(indices[i], cached[i]);
+		}
+		double cached_seconds = seconds_since(start);
+		cache.close();
+
+		// What the chunks take in memory once loaded, against full tile arrays.
+		size_t packed_bytes = 0;
+		int uniform_chunks = 0;
+		for (auto& generation : serial) {
+			tile_store tiles;
+			tiles.assign(generation.tiles);
+			packed_bytes += tiles.memory_size();
+			if (tiles.is_uniform()) {
+				uniform_chunks++;
+			}
+		}
+		size_t full_bytes = serial.size() * tile_store::total_tiles * sizeof(tile_data);
+
+		uint64 serial_hash = combine_hashes(serial);
+		uint64 parallel_hash = combine_hashes(parallel);
+		uint64 cached_hash = combine_hashes(cached);
+		bool passed = (serial_hash == test.expected_hash && parallel_hash == test.expected_hash && cached_hash == test.expected_hash);
+		if (!passed) {
+			failures++;
+		}
+		out << "Seed " << test.seed << ": "
+			<< std::fixed << std::setprecision(1)
+			<< (double)indices.size() / serial_seconds << " chunks/s serial, "
+			<< (double)indices.size() / parallel_seconds << " chunks/s parallel, "
+			<< (double)indices.size() / cached_seconds << " chunks/s cached, "
+			<< packed_bytes / 1024 << " of " << full_bytes / 1024 << " KiB for tiles (" << uniform_chunks << " uniform chunks), "
+			<< "hash " << std::hex << serial_hash << " / " << parallel_hash << " / " << cached_hash << std::dec
+			<< (passed ? " OK" : " MISMATCH") << "\n";
+	}
+	out << (failures == 0 ? "All hashes match" : "Hash mismatch") << "\n";
+	return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,160 @@
+#include "bullet_pool.hpp"
+#include "assets.hpp"
+#include "game.hpp"
+#include "object.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BULLET_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(ne::vector2f) == 2 * sizeof(float), "Bullets are integrated as flat float arrays");
+
+bullet_pool::bullet_pool() : bullet_pool(default_capacity) {
+
+}
+
+bullet_pool::bullet_pool(int capacity) {
+	positions.resize(capacity);
+	previous_positions.resize(capacity);
+	sizes.resize(capacity);
+	velocities.resize(capacity);
+	angles.resize(capacity);
+	types.resize(capacity);
+	owners.resize(capacity);
+	flags.resize(capacity);
+	last_centers.resize(capacity);
+	hit_tiles.resize(capacity);
+	animations.resize(capacity);
+	free_slots.reserve(capacity);
+}
+
+int bullet_pool::capacity() const {
+	return (int)flags.size();
+}
+
+int bullet_pool::count() const {
+	return active_count;
+}
+
+int bullet_pool::slot_count() const {
+	return used_slots;
+}
+
+bool bullet_pool::is_active(int slot) const {
+	return (flags[slot] & BULLET_FLAG_ACTIVE) != 0;
+}
+
+int bullet_pool::spawn(const ne::transform3f& origin, float angle, bool destroy_walls, int type, int owner, float speed) {
+	int slot = -1;
+	if (!free_slots.empty()) {
+		slot = free_slots.back();
+		free_slots.pop_back();
+	} else if (used_slots < capacity()) {
+		slot = used_slots++;
+	} else {
+		overflow_count++;
+		return -1;
+	}
+	ne::vector2f size;
+	animations[slot] = {};
+	if (type == BULLET_NORMAL) {
+		size = textures.bullet.size.to<float>();
+	} else if (type == BULLET_LASER) {
+		size = textures.laser.size.to<float>();
+	} else if (type == BULLET_BLOOD) {
+		size = textures.blood_bullet.frame_size().to<float>();
+		animations[slot].fps = 10.0f;
+	} else if (type == BULLET_SHOTGUN) {
+		size = textures.shotgun_bullet.size.to<float>();
+	} else if (type == BULLET_FLAME) {
+		size = textures.flame_bullet.size.to<float>();
+	}
+	positions[slot] = origin.position.xy + origin.scale.xy / 2.0f - size / 2.0f;
+	previous_positions[slot] = positions[slot];
+	sizes[slot] = size;
+	velocities[slot] = { std::cos(angle) * speed, -(std::sin(angle) * speed) };
+	angles[slot] = angle;
+	types[slot] = (uint8)type;
+	owners[slot] = (uint8)owner;
+	flags[slot] = BULLET_FLAG_ACTIVE | (destroy_walls ? BULLET_FLAG_DESTROYS_WALLS : 0);
+	last_centers[slot] = positions[slot] + size / 2.0f;
+	active_count++;
+	return slot;
+}
+
+void bullet_pool::despawn(int slot) {
+	if (!is_active(slot)) {
+		return;
+	}
+	flags[slot] = 0;
+	velocities[slot] = {};
+	free_slots.push_back(slot);
+	active_count--;
+}
+
+ne::transform3f bullet_pool::transform(int slot) const {
+	ne::transform3f transform;
+	transform.position.xy = positions[slot];
+	transform.scale.xy = sizes[slot];
+	transform.rotation.z = angles[slot];
+	return transform;
+}
+
+int bullet_pool::attack(int slot) const {
+	switch (types[slot]) {
+	case BULLET_NORMAL: return 1;
+	case BULLET_LASER: return 1;
+	case BULLET_BLOOD: return 1;
+	case BULLET_SHOTGUN: return 3;
+	case BULLET_FLAME: return 1;
+	default: return 1;
+	}
+}
+
+void bullet_pool::update(int first, int last) {
+	// Walls are found afterwards by game_world::trace_bullets(), so fast bullets can not skip them.
+	// Free slots are integrated too, since their velocity is zero.
+	float* position = (float*)positions.data();
+	float* previous_position = (float*)previous_positions.data();
+	float* last_center = (float*)last_centers.data();
+	const float* size = (const float*)sizes.data();
+	const float* velocity = (const float*)velocities.data();
+	int count = last * 2;
+	int i = first * 2;
+#if BULLET_SSE2
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 current = _mm_loadu_ps(position + i);
+		_mm_storeu_ps(previous_position + i, current);
+		_mm_storeu_ps(last_center + i, _mm_add_ps(current, _mm_mul_ps(_mm_loadu_ps(size + i), half)));
+		_mm_storeu_ps(position + i, _mm_add_ps(current, _mm_loadu_ps(velocity + i)));
+	}
+#endif
+	for (; i < count; i++) {
+		previous_position[i] = position[i];
+		last_center[i] = position[i] + size[i] * 0.5f;
+		position[i] += velocity[i];
+	}
+}
+
+void bullet_pool::draw(int type, const ne::transform3f& view, float alpha) {
+	for (int slot = 0; slot < used_slots; slot++) {
+		if (!is_active(slot) || types[slot] != type) {
+			continue;
+		}
+		ne::transform3f bullet = transform(slot);
+		bullet.position.xy = interpolate(previous_positions[slot], positions[slot], alpha);
+		if (!bullet.collides_with(view)) {
+			continue;
+		}
+		ne::shader::set_transform(&bullet);
+		if (type == BULLET_BLOOD) {
+			animations[slot].draw();
+		} else {
+			still_quad().draw();
+		}
+	}
+}
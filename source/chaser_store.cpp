@@ -0,0 +1,324 @@
+#include "chaser_store.hpp"
+#include "object.hpp"
+#include "world.hpp"
+
+#include <algorithm>
+
+static const float chaser_acceleration = 0.1f;
+static const float chaser_slowdown_rate = 0.5f;
+static const int chaser_immunity_lasts_ms = 1;
+
+// Longer steps are cut short of a tile, so chasers can not skip over walls.
+static const float chaser_max_step_distance = (float)(world_chunk::tile_pixel_size - 1);
+
+template<typename T>
+static void remove_from(std::vector<T>& values, int index) {
+	if (index != (int)values.size() - 1) {
+		values[index] = std::move(values.back());
+	}
+	values.pop_back();
+}
+
+int chaser_store::count() const {
+	return (int)positions.size();
+}
+
+int chaser_store::add(const ne::vector2f& position) {
+	positions.push_back(position);
+	previous_positions.push_back(position);
+	sizes.push_back({});
+	speeds.push_back(0.0f);
+	max_speeds.push_back(1.0f);
+	max_speeds_normal.push_back(2.0f);
+	max_speeds_fast.push_back(4.0f);
+	holds.push_back({});
+	hearts.push_back(5);
+	directions.push_back(DIRECTION_LEFT);
+	keys.push_back(0);
+	previous_keys.push_back(0);
+	collisions.push_back(0);
+	turn_ticks.push_back(0);
+	wait_ticks.push_back(0);
+	randoms.push_back(seeded_random(++spawn_count * 0xD1B54A32D192ED03ull));
+	simulated_ticks.push_back(-1);
+	immunity_timers.push_back({});
+	animations.push_back({});
+	added.push_back(handles.add());
+	return count() - 1;
+}
+
+void chaser_store::remove(int index) {
+	remove_from(positions, index);
+	remove_from(previous_positions, index);
+	remove_from(sizes, index);
+	remove_from(speeds, index);
+	remove_from(max_speeds, index);
+	remove_from(max_speeds_normal, index);
+	remove_from(max_speeds_fast, index);
+	remove_from(holds, index);
+	remove_from(hearts, index);
+	remove_from(directions, index);
+	remove_from(keys, index);
+	remove_from(previous_keys, index);
+	remove_from(collisions, index);
+	remove_from(turn_ticks, index);
+	remove_from(wait_ticks, index);
+	remove_from(randoms, index);
+	remove_from(simulated_ticks, index);
+	remove_from(immunity_timers, index);
+	remove_from(animations, index);
+	handles.remove_at(index);
+}
+
+void chaser_store::remove_dead() {
+	for (int i = 0; i < count(); i++) {
+		if (hearts[i] < 1) {
+			remove(i);
+			i--;
+		}
+	}
+}
+
+void chaser_store::clear() {
+	positions.clear();
+	previous_positions.clear();
+	sizes.clear();
+	speeds.clear();
+	max_speeds.clear();
+	max_speeds_normal.clear();
+	max_speeds_fast.clear();
+	holds.clear();
+	hearts.clear();
+	directions.clear();
+	keys.clear();
+	previous_keys.clear();
+	collisions.clear();
+	turn_ticks.clear();
+	wait_ticks.clear();
+	randoms.clear();
+	simulated_ticks.clear();
+	immunity_timers.clear();
+	animations.clear();
+	added.clear();
+	handles.clear();
+}
+
+entity_handle chaser_store::handle_at(int index) const {
+	return handles.handle_at(index);
+}
+
+int chaser_store::find(entity_handle handle) const {
+	return handles.find(handle);
+}
+
+ne::transform3f chaser_store::transform(int index) const {
+	ne::transform3f transform;
+	transform.position.xy = positions[index];
+	transform.scale.xy = sizes[index];
+	return transform;
+}
+
+void chaser_store::hurt(int index, int damage) {
+	if (is_immune(index)) {
+		return;
+	}
+	hearts[index] -= damage;
+	immunity_timers[index].start();
+}
+
+bool chaser_store::is_immune(int index) const {
+	return immunity_timers[index].has_started && immunity_timers[index].milliseconds() < chaser_immunity_lasts_ms;
+}
+
+bool chaser_store::should_draw(int index) const {
+	return !immunity_timers[index].has_started || immunity_timers[index].milliseconds() > 50;
+}
+
+int64 chaser_store::first_turn(int index) {
+	return game_world::ticks_from_ms(randoms[index].next_int(1000));
+}
+
+int64 chaser_store::turn(game_world* world, int index) {
+	int64 waited = world->tick - turn_ticks[index];
+	if (waited < wait_ticks[index]) {
+		return wait_ticks[index] - waited + first_turn(index);
+	}
+	wait_ticks[index] = 0;
+	float angle_to_player = world->player.transform.angle_to(transform(index));
+	uint8 key = 0;
+	if (angle_to_player > 45.0f && angle_to_player < 135.0f) {
+		key |= CHASER_KEY_D;
+	} else if (angle_to_player > 225.0f && angle_to_player < 315.0f) {
+		key |= CHASER_KEY_A;
+	}
+	if (angle_to_player > 135.0f && angle_to_player < 225.0f) {
+		key |= CHASER_KEY_S;
+	} else if (angle_to_player < 45.0f || angle_to_player > 315.0f) {
+		key |= CHASER_KEY_W;
+	}
+	keys[index] = key;
+	turn_ticks[index] = world->tick;
+	return first_turn(index);
+}
+
+void chaser_store::update(game_world* world, int first, int last) {
+	for (int i = first; i < last; i++) {
+		previous_positions[i] = positions[i];
+		int steps = world->simulation_steps(positions[i], i, simulated_ticks[i]);
+		if (steps > 0) {
+			update_chaser(world, i, steps);
+		}
+	}
+}
+
+void chaser_store::update_chaser(game_world* world, int index, int steps) {
+	float step = (float)steps;
+	uint8 key = keys[index];
+	max_speeds[index] = max_speeds_normal[index];
+	chaser_hold& hold = holds[index];
+	if (hold.w > 0) {
+		hold.w = std::max(0, hold.w - steps);
+		key |= CHASER_KEY_W;
+		max_speeds[index] = max_speeds_fast[index];
+	}
+	if (hold.s > 0) {
+		hold.s = std::max(0, hold.s - steps);
+		key |= CHASER_KEY_S;
+		max_speeds[index] = max_speeds_fast[index];
+	}
+	if (hold.a > 0) {
+		hold.a = std::max(0, hold.a - steps);
+		key |= CHASER_KEY_A;
+		max_speeds[index] = max_speeds_fast[index];
+	}
+	if (hold.d > 0) {
+		hold.d = std::max(0, hold.d - steps);
+		key |= CHASER_KEY_D;
+		max_speeds[index] = max_speeds_fast[index];
+	}
+	float& speed = speeds[index];
+	speed -= chaser_acceleration * chaser_slowdown_rate * step;
+	if (speed < 0.0f) {
+		speed = 0.0f;
+	}
+	if (key != 0) {
+		move(world, index, key, step);
+		previous_keys[index] = key;
+	} else if (speed > 0.0f) {
+		move(world, index, previous_keys[index], step);
+		speed -= chaser_acceleration * step;
+		if (speed < 0.0f) {
+			speed = 0.0f;
+			previous_keys[index] = 0;
+		}
+	}
+	// Turn around when something is in the way.
+	uint8 collision = collisions[index];
+	if (collision & CHASER_KEY_W) {
+		key = (key & ~CHASER_KEY_W) | CHASER_KEY_S;
+		wait_ticks[index] = game_world::ticks_from_ms(2000);
+	} else if (collision & CHASER_KEY_S) {
+		key = (key & ~CHASER_KEY_S) | CHASER_KEY_W;
+		wait_ticks[index] = game_world::ticks_from_ms(2000);
+	}
+	if (collision & CHASER_KEY_A) {
+		key = (key & ~CHASER_KEY_A) | CHASER_KEY_D;
+		wait_ticks[index] = game_world::ticks_from_ms(2000);
+	} else if (collision & CHASER_KEY_D) {
+		key = (key & ~CHASER_KEY_D) | CHASER_KEY_A;
+		wait_ticks[index] = game_world::ticks_from_ms(2000);
+	}
+	keys[index] = key;
+}
+
+void chaser_store::move(game_world* world, int index, uint8 move_keys, float step) {
+	bool up = (move_keys & CHASER_KEY_W) != 0;
+	bool left = (move_keys & CHASER_KEY_A) != 0;
+	bool down = (move_keys & CHASER_KEY_S) != 0;
+	bool right = (move_keys & CHASER_KEY_D) != 0;
+	float move_speed = std::min(speeds[index] * step, chaser_max_step_distance);
+	if (left != right) {
+		if (left) {
+			move_left(world, index, move_speed);
+		} else {
+			move_right(world, index, move_speed);
+		}
+		move_speed /= 2.0f;
+	}
+	if (up != down) {
+		if (up) {
+			move_up(world, index, move_speed);
+		} else {
+			move_down(world, index, move_speed);
+		}
+	}
+	if ((up != down) || (left != right)) {
+		float& speed = speeds[index];
+		if (speed < max_speeds[index]) {
+			speed += chaser_acceleration * step;
+		}
+		if (speed > max_speeds[index]) {
+			speed = max_speeds[index];
+		}
+	}
+}
+
+void chaser_store::move_left(game_world* world, int index, float speed) {
+	ne::vector2f& position = positions[index];
+	position.x -= speed;
+	collisions[index] &= ~CHASER_KEY_A;
+	if (!world->is_free_at(position + ne::vector2f{ 0.0f, 8.0f })) {
+		position.x += speed;
+		collisions[index] |= CHASER_KEY_A;
+	}
+	directions[index] = DIRECTION_LEFT;
+}
+
+void chaser_store::move_right(game_world* world, int index, float speed) {
+	ne::vector2f& position = positions[index];
+	position.x += speed;
+	collisions[index] &= ~CHASER_KEY_D;
+	if (!world->is_free_at(position + ne::vector2f{ sizes[index].width, 8.0f })) {
+		position.x -= speed;
+		collisions[index] |= CHASER_KEY_D;
+	}
+	directions[index] = DIRECTION_RIGHT;
+}
+
+void chaser_store::move_up(game_world* world, int index, float speed) {
+	ne::vector2f& position = positions[index];
+	position.y -= speed;
+	collisions[index] &= ~CHASER_KEY_W;
+	if (!world->is_free_at(position + ne::vector2f{ 8.0f, 0.0f })) {
+		position.y += speed;
+		collisions[index] |= CHASER_KEY_W;
+	}
+}
+
+void chaser_store::move_down(game_world* world, int index, float speed) {
+	ne::vector2f& position = positions[index];
+	position.y += speed;
+	collisions[index] &= ~CHASER_KEY_S;
+	if (!world->is_free_at(position + ne::vector2f{ 8.0f, sizes[index].height })) {
+		position.y -= speed;
+		collisions[index] |= CHASER_KEY_S;
+	}
+}
+
+void chaser_store::draw(float alpha) {
+	ne::vector2f size = ne::texture::bound()->frame_size().to<float>();
+	for (int i = 0; i < count(); i++) {
+		if (!should_draw(i)) {
+			continue;
+		}
+		sizes[i] = size;
+		ne::transform3f draw_transform = transform(i);
+		draw_transform.position.xy = interpolate(previous_positions[i], positions[i], alpha);
+		if (directions[i] == DIRECTION_RIGHT) {
+			draw_transform.position.x += size.width;
+			draw_transform.scale.width = -size.width;
+		}
+		ne::shader::set_transform(&draw_transform);
+		animations[i].draw();
+	}
+}
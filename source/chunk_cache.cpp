@@ -0,0 +1,252 @@
+#include "chunk_cache.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CHUNK_RECORD_MAGIC   0x4B434C4Cu // "LLCK"
+#define CHUNK_RECORD_VERSION 1
+
+struct cached_object {
+	int8 type;
+	int8 variant;
+	int8 flipped;
+	int8 unused;
+	float x;
+	float y;
+};
+
+// Layout of one chunk on disk. A record is valid once its magic is written.
+struct chunk_record {
+	uint32 magic;
+	uint32 version;
+	uint32 generator;
+	uint32 seed;
+	int32 x;
+	int32 y;
+	uint32 object_count;
+	tile_data tiles[world_chunk::total_tiles];
+	cached_object objects[chunk_cache::max_objects];
+};
+
+static_assert(sizeof(tile_data) == 3, "Chunk records store tile_data as is");
+static_assert(sizeof(chunk_record) == 28 + 3 * world_chunk::total_tiles + 12 * chunk_cache::max_objects, "Unexpected chunk record padding");
+
+static const size_t records_per_region = chunk_cache::region_size * chunk_cache::region_size;
+static const size_t region_file_size = records_per_region * sizeof(chunk_record);
+
+// Temporary caches opened by this process so far.
+static std::atomic<int> temporary_caches = { 0 };
+
+static int floor_div(int value, int divisor) {
+	return (value >= 0 ? value / divisor : (value - divisor + 1) / divisor);
+}
+
+struct chunk_cache::mapped_region {
+	ne::vector2i index;
+	std::string path;
+	chunk_record* records = nullptr;
+#if _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int file = -1;
+#endif
+
+	bool map(bool create) {
+#if _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		// Grows the file to full size. New space reads as zero, which is an empty record.
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, (DWORD)region_file_size, nullptr);
+		if (!mapping) {
+			unmap();
+			return false;
+		}
+		records = (chunk_record*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, region_file_size);
+#else
+		file = ::open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+		if (file < 0) {
+			return false;
+		}
+		struct stat info;
+		if (fstat(file, &info) != 0 || ((size_t)info.st_size < region_file_size && ftruncate(file, region_file_size) != 0)) {
+			unmap();
+			return false;
+		}
+		void* memory = mmap(nullptr, region_file_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		records = (memory == MAP_FAILED ? nullptr : (chunk_record*)memory);
+#endif
+		if (!records) {
+			unmap();
+			return false;
+		}
+		return true;
+	}
+
+	void unmap() {
+#if _WIN32
+		if (records) {
+			UnmapViewOfFile(records);
+		}
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (records) {
+			munmap(records, region_file_size);
+		}
+		if (file >= 0) {
+			::close(file);
+		}
+		file = -1;
+#endif
+		records = nullptr;
+	}
+};
+
+chunk_cache::~chunk_cache() {
+	close();
+}
+
+void chunk_cache::open(uint32 seed, bool persistent) {
+	close();
+	this->seed = seed;
+	this->persistent = persistent;
+#if _WIN32
+	_mkdir("cache");
+	int process = _getpid();
+#else
+	mkdir("cache", 0755);
+	int process = (int)getpid();
+#endif
+	if (persistent) {
+		path_prefix = STRING("cache/" << seed << "_");
+	} else {
+		path_prefix = STRING("cache/temporary_" << process << "_" << temporary_caches++ << "_" << seed << "_");
+	}
+}
+
+void chunk_cache::close() {
+	for (auto& region : regions) {
+		region->unmap();
+		if (!persistent) {
+			std::remove(region->path.c_str());
+		}
+		delete region;
+	}
+	regions.clear();
+}
+
+bool chunk_cache::load(const ne::vector2i& index, chunk_generation& generation) {
+	mapped_region* region = region_at(index, false);
+	if (!region) {
+		return false;
+	}
+	int local_x = index.x - region->index.x * region_size;
+	int local_y = index.y - region->index.y * region_size;
+	const chunk_record& record = region->records[local_y * region_size + local_x];
+	if (record.magic != CHUNK_RECORD_MAGIC || record.version != CHUNK_RECORD_VERSION || record.generator != world_generator::version || record.seed != seed) {
+		return false;
+	}
+	if (record.x != index.x || record.y != index.y || record.object_count > max_objects) {
+		return false;
+	}
+	generation.index = index;
+	std::memcpy(generation.tiles, record.tiles, sizeof(record.tiles));
+	generation.slime_tiles.clear();
+	for (int i = 0; i < world_chunk::total_tiles; i++) {
+		if (generation.tiles[i].type == TILE_SLIME) {
+			generation.slime_tiles.push_back(i);
+		}
+	}
+	generation.objects.resize(record.object_count);
+	for (uint32 i = 0; i < record.object_count; i++) {
+		const cached_object& cached = record.objects[i];
+		placed_object& object = generation.objects[i];
+		object.type = cached.type;
+		object.variant = cached.variant;
+		object.flipped = (cached.flipped != 0);
+		object.position = { cached.x, cached.y };
+	}
+	return true;
+}
+
+bool chunk_cache::store(const chunk_generation& generation) {
+	if (generation.objects.size() > max_objects) {
+		return false;
+	}
+	mapped_region* region = region_at(generation.index, true);
+	if (!region) {
+		return false;
+	}
+	int local_x = generation.index.x - region->index.x * region_size;
+	int local_y = generation.index.y - region->index.y * region_size;
+	chunk_record& record = region->records[local_y * region_size + local_x];
+	record.magic = 0;
+	record.version = CHUNK_RECORD_VERSION;
+	record.generator = world_generator::version;
+	record.seed = seed;
+	record.x = generation.index.x;
+	record.y = generation.index.y;
+	record.object_count = (uint32)generation.objects.size();
+	std::memcpy(record.tiles, generation.tiles, sizeof(record.tiles));
+	for (size_t i = 0; i < generation.objects.size(); i++) {
+		const placed_object& object = generation.objects[i];
+		cached_object& cached = record.objects[i];
+		cached.type = (int8)object.type;
+		cached.variant = (int8)object.variant;
+		cached.flipped = (object.flipped ? 1 : 0);
+		cached.unused = 0;
+		cached.x = object.position.x;
+		cached.y = object.position.y;
+	}
+	record.magic = CHUNK_RECORD_MAGIC;
+	return true;
+}
+
+chunk_cache::mapped_region* chunk_cache::region_at(const ne::vector2i& index, bool create) {
+	ne::vector2i region_index = { floor_div(index.x, region_size), floor_div(index.y, region_size) };
+	mapped_region* region = nullptr;
+	for (auto& existing : regions) {
+		if (existing->index == region_index) {
+			region = existing;
+			break;
+		}
+	}
+	if (!region) {
+		region = new mapped_region();
+		region->index = region_index;
+		region->path = region_path(region_index);
+		regions.push_back(region);
+	} else if (region->records || !create) {
+		// Regions that could not be mapped are kept unmapped, so loads do not look for the file
+		// again until a store creates it.
+		return (region->records ? region : nullptr);
+	}
+	return (region->map(create) ? region : nullptr);
+}
+
+std::string chunk_cache::region_path(const ne::vector2i& region) const {
+	return STRING(path_prefix << region.x << "_" << region.y << ".chunks");
+}
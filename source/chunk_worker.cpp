@@ -0,0 +1,70 @@
+#include "chunk_worker.hpp"
+
+chunk_worker::chunk_worker(const world_generator& generator) : generator(generator) {
+	thread = std::thread([this] {
+		run();
+	});
+}
+
+chunk_worker::~chunk_worker() {
+	running = false;
+	notify();
+	thread.join();
+	chunk_generation* generation = nullptr;
+	while (ready.pop(generation)) {
+		delete generation;
+	}
+}
+
+bool chunk_worker::request(const ne::vector2i& index) {
+	if (!requests.push(index)) {
+		return false;
+	}
+	notify();
+	return true;
+}
+
+std::unique_ptr<chunk_generation> chunk_worker::take() {
+	chunk_generation* generation = nullptr;
+	if (!ready.pop(generation)) {
+		return nullptr;
+	}
+	notify();
+	return std::unique_ptr<chunk_generation>(generation);
+}
+
+void chunk_worker::run() {
+	while (running) {
+		ne::vector2i index;
+		if (!requests.pop(index)) {
+			sleep();
+			continue;
+		}
+		chunk_generation* generation = new chunk_generation();
+		generator.generate(index, *generation);
+		while (!ready.push(generation)) {
+			if (!running) {
+				delete generation;
+				return;
+			}
+			sleep();
+		}
+	}
+}
+
+void chunk_worker::notify() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		is_woken = true;
+	}
+	wake.notify_one();
+}
+
+void chunk_worker::sleep() {
+	// Wakes that came in since the last sleep are not lost, they only cost an extra look at the queues.
+	std::unique_lock<std::mutex> lock(sleep_mutex);
+	wake.wait(lock, [this] {
+		return is_woken;
+	});
+	is_woken = false;
+}
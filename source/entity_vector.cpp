@@ -0,0 +1,51 @@
+#include "entity_vector.hpp"
+
+int handle_table::count() const {
+	return (int)index_slots.size();
+}
+
+entity_handle handle_table::add() {
+	uint32 slot = 0;
+	if (free_slots.empty()) {
+		slot = (uint32)slots.size();
+		slots.emplace_back();
+	} else {
+		slot = free_slots.back();
+		free_slots.pop_back();
+	}
+	slots[slot].index = count();
+	index_slots.push_back(slot);
+	return { slot, slots[slot].generation };
+}
+
+void handle_table::remove_at(int index) {
+	uint32 removed = index_slots[index];
+	uint32 last = index_slots.back();
+	slots[last].index = index;
+	index_slots[index] = last;
+	index_slots.pop_back();
+	slots[removed].index = -1;
+	slots[removed].generation++;
+	free_slots.push_back(removed);
+}
+
+void handle_table::clear() {
+	for (uint32 slot : index_slots) {
+		slots[slot].index = -1;
+		slots[slot].generation++;
+		free_slots.push_back(slot);
+	}
+	index_slots.clear();
+}
+
+entity_handle handle_table::handle_at(int index) const {
+	uint32 slot = index_slots[index];
+	return { slot, slots[slot].generation };
+}
+
+int handle_table::find(entity_handle handle) const {
+	if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation) {
+		return -1;
+	}
+	return slots[handle.slot].index;
+}
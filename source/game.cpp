@@ -6,9 +6,21 @@
 #include <graphics.hpp>
 #include <platform.hpp>
 
+#include <ctime>
 #include <fstream>
 
-game_state::game_state(int player_type) {
+std::future<prepared_world> game_state::next_world;
+
+prepared_world game_state::take_next_world() {
+	if (next_world.valid()) {
+		return next_world.get();
+	}
+	prepared_world prepared;
+	prepared.seed = (uint32)std::time(nullptr);
+	return prepared;
+}
+
+game_state::game_state(int player_type) : world(take_next_world()) {
 	camera.target_chase_aspect.y = 2.0f;
 	camera.target_chase_speed = { 0.25f, 0.25f };
 	camera.zoom = 3.0f;
@@ -18,6 +30,9 @@ game_state::game_state(int player_type) {
 	world.game = this;
 	world.player.type = player_type;
 
+	last_update_ticks = ne::ticks();
+	previous_camera_position = camera.transform.position.xy;
+
 	ne::hide_mouse();
 
 	key = ne::listen([&](ne::keyboard_key_message key) {
@@ -69,27 +84,32 @@ void game_state::load_score() {
 	in >> high_score;
 }
 
+void game_state::prepare_next_world() {
+	next_world = std::async(std::launch::async, game_world::prepare, (uint32)std::time(nullptr), world.generator.size);
+}
+
+void game_state::discard_next_world() {
+	// Waits for the world to be finished, if it is still being prepared.
+	next_world = {};
+}
+
 void game_state::update() {
 	camera.transform.scale.xy = ne::window_size().to<float>();
 	ui_camera.transform.scale.xy = ne::window_size().to<float>();
 
 	camera.target = &world.player.transform;
-	camera.update();
 
-	if (!game_over) {
-		world.update();
-	}
-
-	if (world.player.score > high_score) {
-		high_score = world.player.score;
+	uint64 now = ne::ticks();
+	accumulated_us += now - last_update_ticks;
+	last_update_ticks = now;
+	if (accumulated_us > tick_us * max_ticks_per_update) {
+		accumulated_us = tick_us * max_ticks_per_update;
 	}
-
-	if (world.player.hearts < 1) {
-		if (!game_over) {
-			save_score();
-		}
-		game_over = true;
+	while (accumulated_us >= tick_us) {
+		accumulated_us -= tick_us;
+		tick();
 	}
+	interpolation = (float)accumulated_us / (float)tick_us;
 
 	score_label.render(STRING("Score: " << world.player.score));
 	score_label.transform.position.x = ui_camera.width() / 2.0f - score_label.transform.scale.width / 2.0f;
@@ -108,20 +128,45 @@ void game_state::update() {
 #if _DEBUG
 	debug.set(&fonts.debug, STRING(
 		"Delta " << ne::delta() <<
-		"\nFPS: " << ne::current_fps()
+		"\nFPS: " << ne::current_fps() <<
+		"\nBullets: " << world.bullets.count() << " / " << world.bullets.capacity() << ", " << world.bullets.overflow_count << " dropped"
 	));
 #endif
 }
 
+void game_state::tick() {
+	previous_camera_position = camera.transform.position.xy;
+	camera.update();
+
+	if (!game_over) {
+		world.update();
+	}
+
+	if (world.player.score > high_score) {
+		high_score = world.player.score;
+	}
+
+	if (world.player.hearts < 1) {
+		if (!game_over) {
+			save_score();
+			prepare_next_world();
+		}
+		game_over = true;
+	}
+}
+
 void game_state::draw() {
 	ne::transform3f view;
 	// World
 	shaders.basic.bind();
 	ne::shader::set_color(1.0f);
+	ne::vector2f camera_position = camera.transform.position.xy;
+	camera.transform.position.xy = interpolate(previous_camera_position, camera_position, interpolation);
 	camera.bind();
 	view.position.xy = camera.xy();
 	view.scale.xy = camera.size();
-	world.draw(view);
+	world.draw(view, interpolation);
+	camera.transform.position.xy = camera_position;
 	// UI
 	shaders.basic.bind();
 	ui_camera.bind();
@@ -0,0 +1,107 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+
+job_system::job_system() : job_system(std::max(0, (int)std::thread::hardware_concurrency() - 1)) {
+
+}
+
+job_system::job_system(int worker_count) {
+	for (int i = 0; i <= worker_count; i++) {
+		queues.push_back(std::make_unique<task_queue>());
+	}
+	for (int i = 1; i <= worker_count; i++) {
+		workers.emplace_back([this, i] {
+			work(i);
+		});
+	}
+}
+
+job_system::~job_system() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		is_stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void job_system::parallel_for(int count, int grain, const std::function<void(int first, int last)>& job) {
+	if (count <= 0) {
+		return;
+	}
+	grain = std::max(1, grain);
+	int task_count = (count + grain - 1) / grain;
+	if (task_count == 1 || workers.empty()) {
+		for (int first = 0; first < count; first += grain) {
+			job(first, std::min(count, first + grain));
+		}
+		return;
+	}
+	std::atomic<int> remaining = { task_count };
+	// Dealt out round robin, so every thread starts with its own share.
+	for (int i = 0; i < task_count; i++) {
+		task_queue& queue = *queues[i % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back({ &job, i * grain, std::min(count, (i + 1) * grain), &remaining });
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		queued_tasks += task_count;
+	}
+	wake.notify_all();
+	task found;
+	while (remaining.load(std::memory_order_acquire) > 0) {
+		if (take(0, found)) {
+			execute(found);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool job_system::take(int queue, task& found) {
+	// Our own queue from the back, while the others are stolen from at the front.
+	int count = (int)queues.size();
+	for (int i = 0; i < count; i++) {
+		task_queue& victim = *queues[(queue + i) % count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.tasks.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			found = victim.tasks.back();
+			victim.tasks.pop_back();
+		} else {
+			found = victim.tasks.front();
+			victim.tasks.pop_front();
+		}
+		queued_tasks--;
+		return true;
+	}
+	return false;
+}
+
+void job_system::execute(const task& found) {
+	(*found.job)(found.first, found.last);
+	found.remaining->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void job_system::work(int queue) {
+	task found;
+	while (true) {
+		if (take(queue, found)) {
+			execute(found);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake.wait(lock, [this] {
+			return is_stopping || queued_tasks.load() > 0;
+		});
+		if (is_stopping) {
+			return;
+		}
+	}
+}
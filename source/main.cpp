@@ -4,11 +4,14 @@
 #include "game.hpp"
 #include "assets.hpp"
 #include "menu.hpp"
+#include "benchmark.hpp"
 
 #include <engine.hpp>
 #include <window.hpp>
 #include <graphics.hpp>
 
+#include <string>
+
 void start() {
 	// Black background color.
 	glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
@@ -36,10 +39,14 @@ void start() {
 }
 
 void stop() {
+	game_state::discard_next_world();
 	destroy_assets();
 }
 
 int main(int argc, char** argv) {
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-world") {
+		return run_world_benchmark();
+	}
 	ne::start_engine("Bloody Battle", 800, 600);
 	return ne::enter_loop(start, stop);
 }
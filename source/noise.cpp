@@ -0,0 +1,238 @@
+#include "noise.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// The scalar and SSE2 versions must do the same float operations in the same order.
+static const float skew_2d = 0.366025403784f; // 0.5 * (sqrt(3) - 1)
+static const float unskew_2d = 0.211324865405f; // (3 - sqrt(3)) / 6
+static const float unskew_2d_twice = 2.0f * unskew_2d;
+
+static const float gradient_x[12] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+static const float gradient_y[12] = { 1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+
+static inline int floor_to_int(float x) {
+	int i = (int)x;
+	return x < (float)i ? i - 1 : i;
+}
+
+static inline float corner(int gradient, float x, float y) {
+	float t = 0.5f - x * x - y * y;
+	if (t < 0.0f) {
+		return 0.0f;
+	}
+	t = t * t;
+	return t * t * (gradient_x[gradient] * x + gradient_y[gradient] * y);
+}
+
+void world_noise::seed(uint32 seed) {
+	for (int i = 0; i < 256; i++) {
+		perm[i] = (uint8)i;
+	}
+	// Shuffle with splitmix64, so the table only depends on the seed.
+	uint64 state = seed;
+	for (int i = 255; i > 0; i--) {
+		state += 0x9E3779B97F4A7C15ull;
+		uint64 z = state;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		z = z ^ (z >> 31);
+		int j = (int)(z % (uint64)(i + 1));
+		uint8 swap = perm[i];
+		perm[i] = perm[j];
+		perm[j] = swap;
+	}
+	for (int i = 0; i < 512; i++) {
+		perm[i] = perm[i & 255];
+		perm_mod12[i] = perm[i] % 12;
+	}
+}
+
+float world_noise::raw(float x, float y) const {
+	float s = (x + y) * skew_2d;
+	int i = floor_to_int(x + s);
+	int j = floor_to_int(y + s);
+	float t = (float)(i + j) * unskew_2d;
+	float x0 = x - ((float)i - t);
+	float y0 = y - ((float)j - t);
+	int i1 = (x0 > y0 ? 1 : 0);
+	int j1 = 1 - i1;
+	float x1 = x0 - (float)i1 + unskew_2d;
+	float y1 = y0 - (float)j1 + unskew_2d;
+	float x2 = x0 - 1.0f + unskew_2d_twice;
+	float y2 = y0 - 1.0f + unskew_2d_twice;
+	int ii = i & 255;
+	int jj = j & 255;
+	float n0 = corner(perm_mod12[ii + perm[jj]], x0, y0);
+	float n1 = corner(perm_mod12[ii + i1 + perm[jj + j1]], x1, y1);
+	float n2 = corner(perm_mod12[ii + 1 + perm[jj + 1]], x2, y2);
+	return 70.0f * (n0 + n1 + n2);
+}
+
+float world_noise::octave(int octaves, float persistence, float scale, float x, float y) const {
+	float total = 0.0f;
+	float frequency = scale;
+	float amplitude = 1.0f;
+	float max_amplitude = 0.0f;
+	for (int i = 0; i < octaves; i++) {
+		total += raw(x * frequency, y * frequency) * amplitude;
+		frequency *= 2.0f;
+		max_amplitude += amplitude;
+		amplitude *= persistence;
+	}
+	return total / max_amplitude;
+}
+
+void world_noise::octave_block(float* out, int width, int height, int octaves, float persistence, float scale, int x, int y) const {
+	const int span = 64;
+	float raw[span];
+	float total[span];
+	for (int row = 0; row < height; row++) {
+		for (int column = 0; column < width; column += span) {
+			int count = (width - column < span ? width - column : span);
+			float frequency = scale;
+			float amplitude = 1.0f;
+			float max_amplitude = 0.0f;
+			for (int i = 0; i < count; i++) {
+				total[i] = 0.0f;
+			}
+			for (int octave = 0; octave < octaves; octave++) {
+				raw_row(raw, count, frequency, x + column, y + row);
+				for (int i = 0; i < count; i++) {
+					total[i] += raw[i] * amplitude;
+				}
+				frequency *= 2.0f;
+				max_amplitude += amplitude;
+				amplitude *= persistence;
+			}
+			float* destination = out + row * width + column;
+			for (int i = 0; i < count; i++) {
+				destination[i] = total[i] / max_amplitude;
+			}
+		}
+	}
+}
+
+void world_noise::octave_samples(float* samples, int width, int height, int octaves, float scale, int x, int y) const {
+	float frequency = scale;
+	for (int octave = 0; octave < octaves; octave++) {
+		float* block = samples + octave * width * height;
+		for (int row = 0; row < height; row++) {
+			raw_row(block + row * width, width, frequency, x, y + row);
+		}
+		frequency *= 2.0f;
+	}
+}
+
+void world_noise::combine_octaves(float* out, const float* samples, int count, int octaves, float persistence) {
+	float amplitude = 1.0f;
+	float max_amplitude = 0.0f;
+	for (int i = 0; i < count; i++) {
+		out[i] = 0.0f;
+	}
+	for (int octave = 0; octave < octaves; octave++) {
+		const float* block = samples + octave * count;
+		for (int i = 0; i < count; i++) {
+			out[i] += block[i] * amplitude;
+		}
+		max_amplitude += amplitude;
+		amplitude *= persistence;
+	}
+	for (int i = 0; i < count; i++) {
+		out[i] /= max_amplitude;
+	}
+}
+
+void world_noise::raw_row(float* out, int count, float frequency, int x, int y) const {
+#if NOISE_SSE2
+	raw_row_sse2(out, count, frequency, x, y);
+#else
+	raw_row_scalar(out, count, frequency, x, y);
+#endif
+}
+
+void world_noise::raw_row_scalar(float* out, int count, float frequency, int x, int y) const {
+	for (int i = 0; i < count; i++) {
+		out[i] = raw((float)(x + i) * frequency, (float)y * frequency);
+	}
+}
+
+#if NOISE_SSE2
+
+static inline __m128i floor_to_int_sse2(__m128 x) {
+	__m128i i = _mm_cvttps_epi32(x);
+	__m128 below = _mm_cmplt_ps(x, _mm_cvtepi32_ps(i));
+	return _mm_add_epi32(i, _mm_castps_si128(below)); // true lanes are -1
+}
+
+static inline __m128 corner_sse2(__m128 gradient_x, __m128 gradient_y, __m128 x, __m128 y) {
+	__m128 t = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y));
+	__m128 inside = _mm_cmpge_ps(t, _mm_setzero_ps());
+	t = _mm_mul_ps(t, t);
+	__m128 dot = _mm_add_ps(_mm_mul_ps(gradient_x, x), _mm_mul_ps(gradient_y, y));
+	return _mm_and_ps(inside, _mm_mul_ps(_mm_mul_ps(t, t), dot));
+}
+
+void world_noise::raw_row_sse2(float* out, int count, float frequency, int x, int y) const {
+	const __m128 skew = _mm_set1_ps(skew_2d);
+	const __m128 unskew = _mm_set1_ps(unskew_2d);
+	const __m128 unskew_twice = _mm_set1_ps(unskew_2d_twice);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 noise_y = _mm_mul_ps(_mm_set1_ps((float)y), _mm_set1_ps(frequency));
+	alignas(16) int lane_i[4];
+	alignas(16) int lane_j[4];
+	alignas(16) int lane_i1[4];
+	alignas(16) float lane_gradient_x[3][4];
+	alignas(16) float lane_gradient_y[3][4];
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 noise_x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x + i, x + i + 1, x + i + 2, x + i + 3)), _mm_set1_ps(frequency));
+		__m128 s = _mm_mul_ps(_mm_add_ps(noise_x, noise_y), skew);
+		__m128i cell_i = floor_to_int_sse2(_mm_add_ps(noise_x, s));
+		__m128i cell_j = floor_to_int_sse2(_mm_add_ps(noise_y, s));
+		__m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(cell_i, cell_j)), unskew);
+		__m128 x0 = _mm_sub_ps(noise_x, _mm_sub_ps(_mm_cvtepi32_ps(cell_i), t));
+		__m128 y0 = _mm_sub_ps(noise_y, _mm_sub_ps(_mm_cvtepi32_ps(cell_j), t));
+		__m128 upper = _mm_cmpgt_ps(x0, y0);
+		__m128 i1 = _mm_and_ps(upper, one);
+		__m128 j1 = _mm_sub_ps(one, i1);
+		__m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), unskew);
+		__m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), unskew);
+		__m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), unskew_twice);
+		__m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), unskew_twice);
+		// The permutation lookups are gathers, which SSE2 does not have.
+		_mm_store_si128((__m128i*)lane_i, cell_i);
+		_mm_store_si128((__m128i*)lane_j, cell_j);
+		_mm_store_si128((__m128i*)lane_i1, _mm_cvtps_epi32(i1));
+		for (int lane = 0; lane < 4; lane++) {
+			int ii = lane_i[lane] & 255;
+			int jj = lane_j[lane] & 255;
+			int li1 = lane_i1[lane];
+			int lj1 = 1 - li1;
+			int g0 = perm_mod12[ii + perm[jj]];
+			int g1 = perm_mod12[ii + li1 + perm[jj + lj1]];
+			int g2 = perm_mod12[ii + 1 + perm[jj + 1]];
+			lane_gradient_x[0][lane] = gradient_x[g0];
+			lane_gradient_y[0][lane] = gradient_y[g0];
+			lane_gradient_x[1][lane] = gradient_x[g1];
+			lane_gradient_y[1][lane] = gradient_y[g1];
+			lane_gradient_x[2][lane] = gradient_x[g2];
+			lane_gradient_y[2][lane] = gradient_y[g2];
+		}
+		__m128 n0 = corner_sse2(_mm_load_ps(lane_gradient_x[0]), _mm_load_ps(lane_gradient_y[0]), x0, y0);
+		__m128 n1 = corner_sse2(_mm_load_ps(lane_gradient_x[1]), _mm_load_ps(lane_gradient_y[1]), x1, y1);
+		__m128 n2 = corner_sse2(_mm_load_ps(lane_gradient_x[2]), _mm_load_ps(lane_gradient_y[2]), x2, y2);
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_set1_ps(70.0f), _mm_add_ps(_mm_add_ps(n0, n1), n2)));
+	}
+	raw_row_scalar(out + i, count - i, frequency, x + i, y);
+}
+
+#else
+
+void world_noise::raw_row_sse2(float* out, int count, float frequency, int x, int y) const {
+	raw_row_scalar(out, count, frequency, x, y);
+}
+
+#endif
@@ -3,6 +3,8 @@
 #include "assets.hpp"
 #include "game.hpp"
 
+#include <algorithm>
+
 bool game_object::is_immune() const {
 	return immunity_timer.has_started && immunity_timer.milliseconds() < immunity_lasts_ms;
 }
@@ -199,55 +201,6 @@ void game_object::move_forward(game_world* world, float speed) {
 	}
 }
 
-bullet_object::bullet_object(const ne::transform3f& origin, float angle, bool destroy_walls, int type) : type(type) {
-	can_destroy_wall = destroy_walls;
-	if (type == BULLET_NORMAL) {
-		transform.scale.xy = textures.bullet.size.to<float>();
-	} else if (type == BULLET_LASER) {
-		transform.scale.xy = textures.laser.size.to<float>();
-	} else if (type == BULLET_BLOOD) {
-		transform.scale.xy = textures.blood_bullet.frame_size().to<float>();
-		animation.fps = 10.0f;
-	} else if (type == BULLET_SHOTGUN) {
-		transform.scale.xy = textures.shotgun_bullet.size.to<float>();
-	} else if (type == BULLET_FLAME) {
-		transform.scale.xy = textures.flame_bullet.size.to<float>();
-	}
-	transform.position.xy = origin.position.xy + origin.scale.xy / 2.0f - transform.scale.xy / 2.0f;
-	transform.rotation.z = angle;
-	affected_by_collision = false;
-	move_directions = MOVE_DIRECTIONS_360;
-	max_speed = 6.0f;
-}
-
-void bullet_object::update(game_world* world) {
-	game_object::update(world);
-	move_forward(world, max_speed);
-	if (collision_w || collision_a || collision_s || collision_d) {
-		has_hit_wall = true;
-	}
-}
-
-void bullet_object::draw() {
-	ne::shader::set_transform(&transform);
-	if (type == BULLET_BLOOD) {
-		animation.draw();
-	} else {
-		still_quad().draw();
-	}
-}
-
-int bullet_object::attack() const {
-	switch (type) {
-	case BULLET_NORMAL: return 1;
-	case BULLET_LASER: return 1;
-	case BULLET_BLOOD: return 1;
-	case BULLET_SHOTGUN: return 3;
-	case BULLET_FLAME: return 1;
-	default: return 1;
-	}
-}
-
 enemy_blood_object::enemy_blood_object() {
 	transform.scale.xy = textures.blood.size.to<float>();
 	move_directions = MOVE_DIRECTIONS_360;
@@ -256,14 +209,18 @@ enemy_blood_object::enemy_blood_object() {
 }
 
 void enemy_blood_object::update(game_world* world) {
-	bounce = std::sin((float)ne::ticks() / 200000.0f + random_bounce) * 2.0f;
+	float step = (float)simulation_steps;
+	if (simulation_steps == 1) {
+		bounce = std::sin((float)ne::ticks() / 200000.0f + random_bounce) * 2.0f;
+	}
 	game_object::update(world);
 	collision_w = false;
 	collision_a = false;
 	collision_s = false;
 	collision_d = false;
-	turn_left(world, speed, true);
-	move_forward(world, speed);
+	transform.rotation.z += max_angle_speed * (step - 1.0f);
+	turn_left(world, speed * step, true);
+	move_forward(world, speed * step);
 	accelerate();
 }
 
@@ -280,39 +237,36 @@ void enemy_blood_object::draw() {
 
 enemy_pimple_object::enemy_pimple_object() {
 	transform.scale.xy = textures.pimple.frame_size().to<float>();
-	timer.start();
 	first_reset_ms = ne::random_int(2000);
 	interval_ms = 1000 + ne::random_int(2000);
 	hearts = 10;
 }
 
-void enemy_pimple_object::update(game_world* world) {
-	if (first_reset_ms > 0 && timer.milliseconds() > first_reset_ms) {
-		timer.start();
-		first_reset_ms = -1;
-		return;
+int64 enemy_pimple_object::first_wake() const {
+	return game_world::ticks_from_ms(first_reset_ms + interval_ms * 4);
+}
+
+int64 enemy_pimple_object::wake(game_world* world) {
+	// Pops up, shoots after one interval, goes down after another, and pops up again two later.
+	if (!is_up) {
+		is_up = true;
+		can_shoot = true;
+		return game_world::ticks_from_ms(interval_ms);
 	}
-	if (is_up) {
-		if (timer.milliseconds() > interval_ms * 2) {
-			is_up = false;
-		} else if (timer.milliseconds() > interval_ms && can_shoot) {
-			world->bullets.push_back({ transform, ne::deg_to_rad(0.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(45.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(90.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(135.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(180.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(225.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(270.0f), false, BULLET_BLOOD });
-			world->bullets.push_back({ transform, ne::deg_to_rad(315.0f), false, BULLET_BLOOD });
-			can_shoot = false;
-		}
-	} else {
-		if (timer.milliseconds() > interval_ms * 4) {
-			is_up = true;
-			can_shoot = true;
-			timer.start();
-		}
+	if (can_shoot) {
+		world->bullets.spawn(transform, ne::deg_to_rad(0.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(45.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(90.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(135.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(180.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(225.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(270.0f), false, BULLET_BLOOD);
+		world->bullets.spawn(transform, ne::deg_to_rad(315.0f), false, BULLET_BLOOD);
+		can_shoot = false;
+		return game_world::ticks_from_ms(interval_ms);
 	}
+	is_up = false;
+	return game_world::ticks_from_ms(interval_ms * 2);
 }
 
 void enemy_pimple_object::draw() {
@@ -324,107 +278,31 @@ void enemy_pimple_object::draw() {
 	animation.draw(false);
 }
 
-enemy_chaser_object::enemy_chaser_object() {
-	last_turn.start();
-	acceleration = 0.1f;
-	max_speed = 1.0f;
-	hearts = 5;
+enemy_slime_queen_object::enemy_slime_queen_object() {
+	hearts = 50;
+	transform.scale.xy = textures.queen_slime.frame_size().to<float>();
 }
 
-void enemy_chaser_object::update(game_world* world) {
-	if (last_turn.milliseconds() > ne::random_int(1000) + wait_ms) {
-		wait_ms = 0;
-		float angle_to_player = world->player.transform.angle_to(transform);
-		w = false;
-		a = false;
-		s = false;
-		d = false;
-		if (angle_to_player > 45.0f && angle_to_player < 135.0f) {
-			d = true;
-		} else if (angle_to_player > 225.0f && angle_to_player < 315.0f) {
-			a = true;
-		}
-		if (angle_to_player > 135.0f && angle_to_player < 225.0f) {
-			s = true;
-		} else if (angle_to_player < 45.0f || angle_to_player > 315.0f) {
-			w = true;
-		}
-		last_turn.start();
-	}
-	max_speed = max_speed_normal;
-	if (hold.w > 0) {
-		hold.w--;
-		w = true;
-		max_speed = max_speed_fast;
-	}
-	if (hold.s > 0) {
-		hold.s--;
-		s = true;
-		max_speed = max_speed_fast;
-	}
-	if (hold.a > 0) {
-		hold.a--;
-		a = true;
-		max_speed = max_speed_fast;
-	}
-	if (hold.d > 0) {
-		hold.d--;
-		d = true;
-		max_speed = max_speed_fast;
-	}
-	game_object::update(world);
-	if (collision_w) {
-		w = false;
-		s = true;
-		wait_ms = 2000;
-	} else if (collision_s) {
-		w = true;
-		s = false;
-		wait_ms = 2000;
-	}
-	if (collision_a) {
-		d = true;
-		a = false;
-		wait_ms = 2000;
-	} else if (collision_d) {
-		d = false;
-		a = true;
-		wait_ms = 2000;
-	}
-}
-
-void enemy_chaser_object::draw() {
-	if (!should_draw()) {
-		return;
-	}
-	transform.scale.xy = ne::texture::bound()->frame_size().to<float>();
-	ne::transform3f draw_transform = transform;
-	if (direction == DIRECTION_RIGHT) {
-		draw_transform.position.x += transform.scale.width;
-		draw_transform.scale.width = -transform.scale.width;
+void enemy_slime_queen_object::update(game_world* world) {
+	if (simulation_steps == 1) {
+		bounce = std::sin((float)ne::ticks() / 300000.0f + random_bounce) * 2.0f;
 	}
-	ne::shader::set_transform(&draw_transform);
-	animation.draw();
 }
 
-enemy_slime_queen_object::enemy_slime_queen_object() {
-	hearts = 50;
-	transform.scale.xy = textures.queen_slime.frame_size().to<float>();
-	last_slime_drop.start();
+int64 enemy_slime_queen_object::first_wake() const {
+	return game_world::ticks_from_ms(3000);
 }
 
-void enemy_slime_queen_object::update(game_world* world) {
-	bounce = std::sin((float)ne::ticks() / 300000.0f + random_bounce) * 2.0f;
-	if (last_slime_drop.milliseconds() > 3000) {
-		enemy_chaser_object slime;
-		slime.max_speed_normal = 1.0f;
-		slime.transform.position = transform.position;
-		slime.transform.position.x += transform.scale.width / 2.0f - 4.0f;
-		slime.transform.position.y += transform.scale.height - 4.0f;
-		world->slime_enemies.push_back(slime);
+int64 enemy_slime_queen_object::wake(game_world* world) {
+	ne::vector2f position = transform.position.xy;
+	position.x += transform.scale.width / 2.0f - 4.0f;
+	position.y += transform.scale.height - 4.0f;
+	int slime = world->slime_enemies.add(position);
+	world->slime_enemies.max_speeds_normal[slime] = 1.0f;
+	if (world->simulation_interval(transform.position.xy) == 1) {
 		audio.slime.play(15);
-		last_slime_drop.start();
 	}
+	return game_world::ticks_from_ms(3000);
 }
 
 void enemy_slime_queen_object::draw() {
@@ -442,36 +320,26 @@ void enemy_slime_queen_object::draw() {
 }
 
 void enemy_slime_queen_object::explode(game_world* world) {
-	enemy_chaser_object slime;
-	slime.max_speed_normal = 1.0f;
-	slime.max_speed_fast = 8.0f;
-	slime.speed = 8.0f;
-	slime.transform.position.xy = transform.position.xy + transform.scale.xy / 2.0f - 4.0f;
 	int ticks = 1000;
-	// Up
-	slime.hold = { ticks, 0, 0, 0 };
-	world->slime_enemies.push_back(slime);
-	// Left
-	slime.hold = { 0, ticks, 0, 0 };
-	world->slime_enemies.push_back(slime);
-	// Up left
-	slime.hold = { ticks, ticks, 0, 0 };
-	world->slime_enemies.push_back(slime);
-	// Down
-	slime.hold = { 0, 0, ticks, 0 };
-	world->slime_enemies.push_back(slime);
-	// Down left
-	slime.hold = { 0, ticks, ticks, 0 };
-	world->slime_enemies.push_back(slime);
-	// Right
-	slime.hold = { 0, 0, 0, ticks };
-	world->slime_enemies.push_back(slime);
-	// Up right
-	slime.hold = { ticks, 0, 0, ticks };
-	world->slime_enemies.push_back(slime);
-	// Down right
-	slime.hold = { 0, ticks, 0, ticks };
-	world->slime_enemies.push_back(slime);
+	chaser_hold holds[8] = {
+		{ ticks, 0, 0, 0 }, // Up
+		{ 0, ticks, 0, 0 }, // Left
+		{ ticks, ticks, 0, 0 }, // Up left
+		{ 0, 0, ticks, 0 }, // Down
+		{ 0, ticks, ticks, 0 }, // Down left
+		{ 0, 0, 0, ticks }, // Right
+		{ ticks, 0, 0, ticks }, // Up right
+		{ 0, ticks, 0, ticks } // Down right
+	};
+	ne::vector2f position = transform.position.xy + transform.scale.xy / 2.0f - 4.0f;
+	auto& slimes = world->slime_enemies;
+	for (auto& hold : holds) {
+		int slime = slimes.add(position);
+		slimes.max_speeds_normal[slime] = 1.0f;
+		slimes.max_speeds_fast[slime] = 8.0f;
+		slimes.speeds[slime] = 8.0f;
+		slimes.holds[slime] = hold;
+	}
 	audio.slime.play(50);
 }
 
@@ -542,15 +410,26 @@ void artery_object::draw() {
 zindo_blood_object::zindo_blood_object() {
 	hearts = 10;
 	animation.fps = 5.0f + ne::random_float(5.0f);
+	frame_ticks = std::max<int64>(1, game_world::ticks_from_ms((int64)(1000.0f / animation.fps)));
 	transform.scale.xy = textures.artery.frame_size().to<float>();
-	last_shot.start();
 }
 
-void zindo_blood_object::update(game_world* world) {
-	if (animation.frame > 3 && last_shot.milliseconds() > 1000) {
-		world->bullets.push_back({ transform, ne::deg_to_rad(90.0f), false, BULLET_BLOOD });
-		last_shot.start();
+int64 zindo_blood_object::first_wake() const {
+	return shot_frame * frame_ticks;
+}
+
+int64 zindo_blood_object::wake(game_world* world) {
+	// Sleeping outside the active chunks can put the wake off the shot frame, so it is lined up again.
+	int64 cycle = frames * frame_ticks;
+	int64 since_shot = ((world->tick - spawn_tick - shot_frame * frame_ticks) % cycle + cycle) % cycle;
+	if (since_shot == 0) {
+		world->bullets.spawn(transform, ne::deg_to_rad(90.0f), false, BULLET_BLOOD);
 	}
+	return cycle - since_shot;
+}
+
+void zindo_blood_object::animate(int64 tick) {
+	animation.frame = (int)(((tick - spawn_tick) / frame_ticks) % frames);
 }
 
 void zindo_blood_object::draw() {
@@ -558,34 +437,42 @@ void zindo_blood_object::draw() {
 		return;
 	}
 	ne::shader::set_transform(&transform);
-	animation.draw();
+	animation.draw(false);
 }
 
 virus_object::virus_object() {
 	animation.fps = 5.0f;
 	transform.scale.xy = textures.virus.frame_size().to<float>();
 	hearts = 20;
-	waiter.start();
-	made_sound.start();
 }
 
 void virus_object::update(game_world* world) {
-	if (waiter.milliseconds() < 3000) {
+	if (!is_awake) {
 		return;
 	}
-	angle += 0.25f;
+	angle += 0.25f * (float)simulation_steps;
 	if (angle >= 360.0f) {
 		angle = 0.0f;
 	}
-	if (made_sound.milliseconds() > 3000 + ne::random_int(3000)) {
-		audio.beam.play(10);
-		made_sound.start();
-	}
 	ne::transform3f origin = transform;
 	origin.position.y -= 16.0f;
-	world->bullets.push_back({ origin, ne::deg_to_rad(angle), false, BULLET_LASER });
-	world->bullets.back().max_speed = 16.0f;
-	world->bullets.back().type = BULLET_LASER;
+	world->bullets.spawn(origin, ne::deg_to_rad(angle), false, BULLET_LASER, BULLET_OWNER_ENEMY, 16.0f);
+}
+
+int64 virus_object::first_wake() const {
+	return game_world::ticks_from_ms(3000);
+}
+
+int64 virus_object::wake(game_world* world) {
+	// Starts shooting on the first wake, and hums every 3 to 6 seconds after.
+	if (!is_awake) {
+		is_awake = true;
+		return game_world::ticks_from_ms(ne::random_int(3000));
+	}
+	if (world->simulation_interval(transform.position.xy) == 1) {
+		audio.beam.play(10);
+	}
+	return game_world::ticks_from_ms(3000 + ne::random_int(3000));
 }
 
 void virus_object::draw() {
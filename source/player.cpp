@@ -105,19 +105,13 @@ void player_object::shoot(game_world* world) {
 	origin.scale.xy = textures.gun[0].size.to<float>();
 
 	if (gun == GUN_DEAGLE) {
-		bullet_object bullet(origin, angle_to_mouse, true, BULLET_NORMAL);
-		bullet.by_player = true;
-		world->bullets.push_back(bullet);
+		world->bullets.spawn(origin, angle_to_mouse, true, BULLET_NORMAL, BULLET_OWNER_PLAYER);
 		audio.bullet[1].play(15);
 	} else if (gun == GUN_SHOTGUN) {
-		bullet_object bullet(origin, angle_to_mouse, true, BULLET_SHOTGUN);
-		bullet.by_player = true;
-		world->bullets.push_back(bullet);
+		world->bullets.spawn(origin, angle_to_mouse, true, BULLET_SHOTGUN, BULLET_OWNER_PLAYER);
 		audio.bullet[1].play(15);
 	} else if (gun == GUN_FLAME) {
-		bullet_object bullet(origin, angle_to_mouse, true, BULLET_FLAME);
-		bullet.by_player = true;
-		world->bullets.push_back(bullet);
+		world->bullets.spawn(origin, angle_to_mouse, true, BULLET_FLAME, BULLET_OWNER_PLAYER);
 		audio.bullet[2].play(15);
 	}
 
@@ -0,0 +1,30 @@
+#include "seeded_random.hpp"
+
+seeded_random::seeded_random(uint64 seed) : state(seed) {
+
+}
+
+seeded_random::seeded_random(uint32 world_seed, const ne::vector2i& index) {
+	state = ((uint64)world_seed * 0x9E3779B97F4A7C15ull) ^ (((uint64)(uint32)index.x << 32) | (uint64)(uint32)index.y);
+	next();
+}
+
+uint32 seeded_random::next() {
+	state += 0x9E3779B97F4A7C15ull;
+	uint64 z = state;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return (uint32)((z ^ (z >> 31)) >> 32);
+}
+
+float seeded_random::next_float() {
+	return (float)(next() >> 8) / (float)(1 << 24);
+}
+
+bool seeded_random::chance(float percent) {
+	return next_float() < percent;
+}
+
+int seeded_random::next_int(int max) {
+	return (int)(next() % (uint32)(max + 1));
+}
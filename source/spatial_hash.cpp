@@ -0,0 +1,65 @@
+#include "spatial_hash.hpp"
+
+#include <engine.hpp>
+
+#include <cmath>
+
+void spatial_hash::clear() {
+	added.clear();
+	entries.clear();
+}
+
+void spatial_hash::add(int type, int index, const ne::transform3f& transform) {
+	int first_x, first_y, last_x, last_y;
+	cell_range(transform, first_x, first_y, last_x, last_y);
+	for (int y = first_y; y <= last_y; y++) {
+		for (int x = first_x; x <= last_x; x++) {
+			added.push_back({});
+			added.back().bucket = bucket_at(x, y);
+			added.back().item = { type, index };
+		}
+	}
+}
+
+void spatial_hash::build() {
+	bucket_start.assign(bucket_count + 1, 0);
+	for (auto& added_item : added) {
+		bucket_start[added_item.bucket + 1]++;
+	}
+	for (int i = 0; i < bucket_count; i++) {
+		bucket_start[i + 1] += bucket_start[i];
+	}
+	// Scatter in the order the entries were added, so each bucket stays sorted by type and index.
+	std::vector<int> next(bucket_start.begin(), bucket_start.end() - 1);
+	entries.resize(added.size());
+	for (auto& added_item : added) {
+		entries[next[added_item.bucket]++] = added_item.item;
+	}
+}
+
+void spatial_hash::query(const ne::transform3f& transform, std::vector<entry>& found) const {
+	found.clear();
+	if (entries.empty()) {
+		return;
+	}
+	int first_x, first_y, last_x, last_y;
+	cell_range(transform, first_x, first_y, last_x, last_y);
+	for (int y = first_y; y <= last_y; y++) {
+		for (int x = first_x; x <= last_x; x++) {
+			int bucket = bucket_at(x, y);
+			found.insert(found.end(), entries.begin() + bucket_start[bucket], entries.begin() + bucket_start[bucket + 1]);
+		}
+	}
+}
+
+int spatial_hash::bucket_at(int x, int y) {
+	return (int)(((uint32)x * 73856093u ^ (uint32)y * 19349663u) & (bucket_count - 1));
+}
+
+void spatial_hash::cell_range(const ne::transform3f& transform, int& first_x, int& first_y, int& last_x, int& last_y) {
+	const float size = (float)cell_size;
+	first_x = (int)std::floor(transform.position.x / size);
+	first_y = (int)std::floor(transform.position.y / size);
+	last_x = (int)std::floor((transform.position.x + transform.scale.width) / size);
+	last_y = (int)std::floor((transform.position.y + transform.scale.height) / size);
+}
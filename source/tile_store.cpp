@@ -0,0 +1,91 @@
+#include "tile_store.hpp"
+
+#include <algorithm>
+
+static uint32 tile_key(const tile_data& tile) {
+	return (uint32)(uint8)tile.type | ((uint32)(uint8)tile.extra << 8) | ((uint32)(uint8)tile.health << 16);
+}
+
+void tile_store::assign(const tile_data* tiles) {
+	palette.clear();
+	packed.clear();
+	full.clear();
+	std::vector<uint32> keys;
+	uint8 indices[total_tiles];
+	for (int i = 0; i < total_tiles; i++) {
+		uint32 key = tile_key(tiles[i]);
+		size_t index = 0;
+		while (index < keys.size() && keys[index] != key) {
+			index++;
+		}
+		if (index == keys.size()) {
+			if (keys.size() == 256) {
+				// Too many different tiles to be worth packing.
+				palette.clear();
+				full.assign(tiles, tiles + total_tiles);
+				bits = 0;
+				return;
+			}
+			keys.push_back(key);
+			palette.push_back(tiles[i]);
+		}
+		indices[i] = (uint8)index;
+	}
+	if (palette.size() == 1) {
+		bits = 0;
+	} else if (palette.size() <= 2) {
+		bits = 1;
+	} else if (palette.size() <= 4) {
+		bits = 2;
+	} else if (palette.size() <= 16) {
+		bits = 4;
+	} else {
+		bits = 8;
+	}
+	if (bits == 0) {
+		return;
+	}
+	packed.assign(total_tiles * bits / 64, 0);
+	for (int i = 0; i < total_tiles; i++) {
+		int bit = i * bits;
+		packed[bit / 64] |= (uint64)indices[i] << (bit % 64);
+	}
+}
+
+void tile_store::copy_to(tile_data* tiles) const {
+	if (!full.empty()) {
+		std::copy(full.begin(), full.end(), tiles);
+		return;
+	}
+	for (int i = 0; i < total_tiles; i++) {
+		tiles[i] = get(i);
+	}
+}
+
+void tile_store::clear() {
+	// Swapped with empty vectors, so the memory is released.
+	std::vector<tile_data>{ tile_data{} }.swap(palette);
+	std::vector<uint64>{}.swap(packed);
+	std::vector<tile_data>{}.swap(full);
+	bits = 0;
+}
+
+tile_data* tile_store::edit(int i) {
+	if (full.empty()) {
+		std::vector<tile_data> expanded(total_tiles);
+		copy_to(expanded.data());
+		full.swap(expanded);
+		std::vector<tile_data>{}.swap(palette);
+		std::vector<uint64>{}.swap(packed);
+		bits = 0;
+	}
+	return &full[i];
+}
+
+bool tile_store::is_uniform() const {
+	return full.empty() && bits == 0;
+}
+
+size_t tile_store::memory_size() const {
+	return palette.capacity() * sizeof(tile_data) + packed.capacity() * sizeof(uint64) + full.capacity() * sizeof(tile_data);
+}
@@ -1,22 +1,66 @@
 #include "world.hpp"
 #include "assets.hpp"
 #include "game.hpp"
+#include "chunk_worker.hpp"
+#include "chunk_cache.hpp"
+#include "job_system.hpp"
 
 #include <graphics.hpp>
 #include <camera.hpp>
 #include <platform.hpp>
-#include <simplex_noise.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
 
 world_chunk::world_chunk() {
 	transform.scale.xy = 1.0f;
+	for (int side = 0; side < 4; side++) {
+		copy_halo(side, nullptr);
+	}
+}
+
+ne::vector2f world_chunk::origin(const ne::vector2i& index) {
+	ne::vector2f position = (index * ne::vector2i{ pixel_width, pixel_height }).to<float>();
+	if (offset_to_grid) {
+		position.x += (float)index.x * 8.0f;
+		position.y += (float)index.y * 8.0f;
+	}
+	return position;
 }
 
 void world_chunk::set_index(const ne::vector2i& index) {
 	this->index = index;
-	transform.position.xy = (index * ne::vector2i{ pixel_width, pixel_height }).to<float>();
-	if (offset_to_grid) {
-		transform.position.x += (float)index.x * 8.0f;
-		transform.position.y += (float)index.y * 8.0f;
+	transform.position.xy = origin(index);
+}
+
+void world_chunk::load(const ne::vector2i& index) {
+	set_index(index);
+	is_resident = true;
+	is_generated = false;
+	is_requested = false;
+	is_modified = false;
+	needs_rendering = true;
+}
+
+void world_chunk::unload() {
+	is_resident = false;
+	is_generated = false;
+	is_requested = false;
+	is_modified = false;
+	tiles.clear();
+	slime_tiles.clear();
+	pimple_enemies.clear();
+	arteries.clear();
+	zindo_bloods.clear();
+	neurons.clear();
+	spikes.clear();
+	for (int side = 0; side < 4; side++) {
+		copy_halo(side, nullptr);
+	}
+	if (shape.exists()) {
+		shape.destroy();
 	}
 }
 
@@ -37,7 +81,7 @@ void world_chunk::draw_slime() {
 	for (auto& slime : slime_tiles) {
 		int x = slime.i % tiles_per_row;
 		int y = slime.i / tiles_per_row;
-		tile_data* below = at(x, y + 1);
+		const tile_data* below = at(x, y + 1);
 		if (below) {
 			if (below->type == TILE_SLIME || below->type == TILE_WALL) {
 				continue;
@@ -46,7 +90,8 @@ void world_chunk::draw_slime() {
 				continue;
 			}
 		}
-		if (tiles[slime.i].extra >= TILE_EX_BONE_BASE_LEFT && tiles[slime.i].extra <= TILE_EX_BONE_TOP_RIGHT) {
+		const tile_data& tile = tiles.get(slime.i);
+		if (tile.extra >= TILE_EX_BONE_BASE_LEFT && tile.extra <= TILE_EX_BONE_TOP_RIGHT) {
 			continue;
 		}
 		draw_transform.position.xy = transform.position.xy;
@@ -58,42 +103,50 @@ void world_chunk::draw_slime() {
 	}
 }
 
-tile_data* world_chunk::at(int x, int y) {
-	if (x < 0 || y < 0 || x >= tiles_per_row || y >= tiles_per_column) {
-		ne::vector2i offset;
-		if (x < 0) {
-			offset.x = -1;
-		} else if (x >= tiles_per_row) {
-			offset.x = 1;
+const tile_data* world_chunk::at(int x, int y) const {
+	const tile_data* tile = nullptr;
+	if (x >= 0 && x < tiles_per_row && y >= 0 && y < tiles_per_column) {
+		return &tiles.get(tiles_per_row * y + x);
+	} else if (x >= 0 && x < tiles_per_row) {
+		if (y == -1) {
+			tile = &halo[HALO_UP][x];
+		} else if (y == tiles_per_column) {
+			tile = &halo[HALO_DOWN][x];
 		}
-		if (y < 0) {
-			offset.y = -1;
-		} else if (y >= tiles_per_column) {
-			offset.y = 1;
+	} else if (y >= 0 && y < tiles_per_column) {
+		if (x == -1) {
+			tile = &halo[HALO_LEFT][y];
+		} else if (x == tiles_per_row) {
+			tile = &halo[HALO_RIGHT][y];
 		}
-		world_chunk* next = world->at(index.x + offset.x, index.y + offset.y);
-		if (!next) {
-			return nullptr;
-		}
-		if (offset.x == 1) {
-			x -= tiles_per_row;
-		} else if (offset.x == -1) {
-			x += tiles_per_row;
-		}
-		if (offset.y == 1) {
-			y -= tiles_per_column;
-		} else if (offset.y == -1) {
-			y += tiles_per_column;
+	}
+	return (tile && tile->type != TILE_NONE ? tile : nullptr);
+}
+
+const tile_data& world_chunk::edge_tile(int side, int i) const {
+	switch (side) {
+	case HALO_UP: return tiles.get(i);
+	case HALO_DOWN: return tiles.get((tiles_per_column - 1) * tiles_per_row + i);
+	case HALO_LEFT: return tiles.get(i * tiles_per_row);
+	default: return tiles.get(i * tiles_per_row + tiles_per_row - 1);
+	}
+}
+
+void world_chunk::copy_halo(int side, const world_chunk* neighbour) {
+	// The opposite side of the neighbour touches this side.
+	for (int i = 0; i < tiles_per_row; i++) {
+		if (neighbour) {
+			halo[side][i] = neighbour->edge_tile(side ^ 1, i);
+		} else {
+			halo[side][i] = { TILE_NONE, -1, 0 };
 		}
-		return next->at(x, y);
 	}
-	return &tiles[tiles_per_row * y + x];
 }
 
 void world_chunk::render_tile(int type) {
 	for (int x = 0; x < tiles_per_row; x++) {
 		for (int y = 0; y < tiles_per_column; y++) {
-			tile_data tile = tiles[y * tiles_per_row + x];
+			tile_data tile = tiles.get(y * tiles_per_row + x);
 			if (tile.type != type) {
 				continue;
 			}
@@ -120,10 +173,10 @@ void world_chunk::render_tile(int type) {
 			float step_x = size.x / (float)textures.tiles.size.width;
 			float step_y = size.y / (float)textures.tiles.size.height;
 			if (tile.type != TILE_BG_BOTTOM) {
-				tile_data* up = at(x, y - 1);
-				tile_data* down = at(x, y + 1);
-				tile_data* left = at(x - 1, y);
-				tile_data* right = at(x + 1, y);
+				const tile_data* up = at(x, y - 1);
+				const tile_data* down = at(x, y + 1);
+				const tile_data* left = at(x - 1, y);
+				const tile_data* right = at(x + 1, y);
 				if (up && up->type != tile.type) {
 					uv1.y -= step_y / 4.0f;
 					step_y += step_y / 4.0f;
@@ -160,7 +213,7 @@ void world_chunk::render_tile_ex(int from, int to) {
 	float step_y = size.y / (float)textures.tiles.size.height;
 	for (int x = 0; x < tiles_per_row; x++) {
 		for (int y = 0; y < tiles_per_column; y++) {
-			tile_data tile = tiles[y * tiles_per_row + x];
+			tile_data tile = tiles.get(y * tiles_per_row + x);
 			if (tile.extra < from || tile.extra > to) {
 				continue;
 			}
@@ -209,61 +262,110 @@ void world_chunk::render() {
 	needs_rendering = false;
 }
 
-std::pair<tile_data*, ne::vector2i> world_chunk::tile_at_world_position(const ne::vector2f& position) {
-	ne::vector2i tile_index = position.to<int>();
-	tile_index.x -= index.x * pixel_width;
-	tile_index.y -= index.y * pixel_height;
-	tile_index.x -= tile_index.x % tile_pixel_size;
-	tile_index.y -= tile_index.y % tile_pixel_size;
+std::pair<const tile_data*, ne::vector2i> world_chunk::tile_at_world_position(const ne::vector2f& position) {
+	// Floored, so positions left of or above the origin land in the right tile.
+	ne::vector2i tile_index = {
+		(int)std::floor(position.x) - index.x * pixel_width,
+		(int)std::floor(position.y) - index.y * pixel_height
+	};
 	tile_index.x /= tile_pixel_size;
 	tile_index.y /= tile_pixel_size;
 	return { at(tile_index.x, tile_index.y), tile_index };
 }
 
-game_world::game_world() {
-	ne::set_simplex_noise_seed((uint32)std::time(nullptr));
-	generator.world = this;
-	ne::vector2i index;
-	for (int i = 0; i < total_chunks; i++) {
-		auto& chunk = chunks[i];
+game_world::game_world() : game_world((uint32)std::time(nullptr), { 32, 32 }, false, {}, bullet_pool::default_capacity) {
+
+}
+
+game_world::game_world(uint32 seed) : game_world(seed, { 32, 32 }) {
+
+}
+
+game_world::game_world(uint32 seed, const ne::vector2i& size, int bullet_capacity) : game_world(seed, size, true, {}, bullet_capacity) {
+
+}
+
+game_world::game_world(const prepared_world& prepared, int bullet_capacity) : game_world(prepared.seed, prepared.size, false, prepared.chunks, bullet_capacity) {
+
+}
+
+game_world::game_world(uint32 seed, const ne::vector2i& size, bool keep_cache, const std::vector<chunk_generation>& prepared, int bullet_capacity) : bullets(bullet_capacity) {
+	generator.set_seed(seed);
+	generator.size = size;
+	if (keep_cache) {
+		cache = std::make_unique<chunk_cache>();
+		cache->open(seed, true);
+	}
+	damaged_chunks = std::make_unique<chunk_cache>();
+	damaged_chunks->open(seed, false);
+	std::fill(std::begin(solidity), std::end(solidity), 0);
+	for (auto& chunk : chunks) {
 		chunk.world = this;
-		chunk.set_index(index);
-		if (index.x == 0 || index.x == chunks_per_row - 1 || index.y == 0 || index.y == chunks_per_column - 1) {
-			generator.border(chunk.index);
-		} else {
-			generator.normal(chunk.index);
-		}
-		if (++index.x % chunks_per_row == 0) {
-			++index.y;
-			index.x = 0;
-		}
 	}
-	player.transform.position.x = (float)(chunks_per_row * world_chunk::pixel_width) / 2.0f;
-	player.transform.position.y = (float)(chunks_per_column * world_chunk::pixel_height) / 2.0f;
-	while (!is_free_at(player.transform.position.xy)) {
+	// Start in the middle of the world. Unbounded worlds start at the origin.
+	player.transform.position.x = (float)(size.x * world_chunk::pixel_width) / 2.0f;
+	player.transform.position.y = (float)(size.y * world_chunk::pixel_height) / 2.0f;
+	center_window(chunk_index_at_world_position(player.transform.position.xy));
+	for (auto& generation : prepared) {
+		apply(generation);
+	}
+	while (!is_area_free(player.transform.position.xy, player.transform.scale.xy)) {
 		player.transform.position.x += 20.0f;
+		center_window(chunk_index_at_world_position(player.transform.position.xy));
+	}
+	last_player_position = player.transform.position.xy;
+	worker = std::make_unique<chunk_worker>(generator);
+	jobs = std::make_unique<job_system>();
+}
+
+game_world::~game_world() {
+	// Stop the worker before the caches are closed. Damage is not kept past the session.
+	jobs.reset();
+	worker.reset();
+}
+
+prepared_world game_world::prepare(uint32 seed, const ne::vector2i& size) {
+	prepared_world prepared;
+	prepared.seed = seed;
+	prepared.size = size;
+	world_generator generator;
+	generator.set_seed(seed);
+	generator.size = size;
+	// The chunks around the middle of the world, where the player starts.
+	ne::vector2i start = { size.x / 2, size.y / 2 };
+	std::vector<ne::vector2i> indices;
+	for (int y = start.y - stream_radius; y <= start.y + stream_radius; y++) {
+		for (int x = start.x - stream_radius; x <= start.x + stream_radius; x++) {
+			if ((size.x <= 0 || (x >= 0 && x < size.x)) && (size.y <= 0 || (y >= 0 && y < size.y))) {
+				indices.push_back({ x, y });
+			}
+		}
 	}
+	job_system jobs;
+	generator.generate(indices, prepared.chunks, jobs);
+	return prepared;
+}
+
+uint32 game_world::seed() const {
+	return generator.seed;
 }
 
-void game_world::update_items(std::vector<item_object>& items, int type, int max_of) {
+void game_world::update_items(entity_vector<item_object>& items, int type, int max_of) {
 	if ((int)items.size() < max_of) {
 		world_chunk* player_chunk = chunk_at_world_position(player.transform.position.xy);
-		if (player_chunk) {
-			int x = -1;
-			int y = -1;
-			do {
-				x = ne::random_int(0, world_chunk::tiles_per_row - 1);
-				y = ne::random_int(0, world_chunk::tiles_per_column - 1);
-			} while (player_chunk->tiles[y * world_chunk::tiles_per_row + x].type == TILE_WALL);
+		ne::vector2f position;
+		if (player_chunk && find_free_tile(*player_chunk, position)) {
 			items.push_back({});
-			items.back().transform.position.xy = player_chunk->transform.position.xy;
-			items.back().transform.position.x += (float)x * (float)world_chunk::tile_pixel_size;
-			items.back().transform.position.y += (float)y * (float)world_chunk::tile_pixel_size;
+			items.back().transform.position.xy = position;
 		}
 	}
+	jobs->parallel_for(items.size(), 64, [&](int first, int last) {
+		for (int i = first; i < last; i++) {
+			items[i].update(this);
+		}
+	});
 	for (int i = 0; i < (int)items.size(); i++) {
 		auto& item = items[i];
-		item.update(this);
 		if (item.transform.collides_with(player.transform)) {
 			if (type == ITEM_PILL) {
 				if (++player.hearts > 3) {
@@ -280,87 +382,257 @@ void game_world::update_items(std::vector<item_object>& items, int type, int max
 				player.gun = GUN_FLAME;
 				player.score += 5;
 			}
-			items.erase(items.begin() + i);
+			items.remove_at(i);
 			i--;
 		} else if (item.transform.distance_to(player.transform) > 512.0f) {
-			items.erase(items.begin() + i);
+			items.remove_at(i);
 			i--;
 		}
 	}
 }
 
+void game_world::generate(world_chunk& chunk) {
+	if (chunk.is_generated) {
+		return;
+	}
+	chunk_generation generation;
+	if (!load_cached(chunk.index, generation)) {
+		generator.generate(chunk.index, generation);
+		if (cache) {
+			cache->store(generation);
+		}
+	}
+	apply(generation);
+}
+
+void game_world::generate(const std::vector<world_chunk*>& chunks) {
+	std::vector<ne::vector2i> indices;
+	chunk_generation cached;
+	for (auto& chunk : chunks) {
+		if (!chunk || chunk->is_generated) {
+			continue;
+		}
+		if (load_cached(chunk->index, cached)) {
+			apply(cached);
+		} else {
+			indices.push_back(chunk->index);
+		}
+	}
+	if (indices.empty()) {
+		return;
+	}
+	std::vector<chunk_generation> generations;
+	generator.generate(indices, generations, *jobs);
+	// Merged in request order, so the result does not depend on which thread finished first.
+	for (auto& generation : generations) {
+		if (cache) {
+			cache->store(generation);
+		}
+		apply(generation);
+	}
+}
+
+void game_world::apply(const chunk_generation& generation) {
+	world_chunk* resident = slot(generation.index.x, generation.index.y);
+	if (!resident) {
+		return;
+	}
+	world_chunk& chunk = *resident;
+	chunk.tiles.assign(generation.tiles);
+	chunk.slime_tiles.clear();
+	for (int i : generation.slime_tiles) {
+		chunk.slime_tiles.push_back({ i });
+	}
+	int chunk_slot = (int)(&chunk - chunks);
+	for (auto& object : generation.objects) {
+		entity_handle handle;
+		switch (object.type) {
+		case PLACED_PIMPLE:
+			handle = chunk.pimple_enemies.push_back({});
+			chunk.pimple_enemies.back().transform.position.xy = object.position;
+			wake_after(chunk.pimple_enemies.back().first_wake(), { WAKE_PIMPLE, chunk_slot, handle });
+			break;
+		case PLACED_ARTERY:
+			chunk.arteries.push_back({});
+			chunk.arteries.back().type = object.variant;
+			chunk.arteries.back().is_flipped = object.flipped;
+			chunk.arteries.back().transform.position.xy = object.position;
+			break;
+		case PLACED_ZINDO_BLOOD:
+			handle = chunk.zindo_bloods.push_back({});
+			chunk.zindo_bloods.back().transform.position.xy = object.position;
+			chunk.zindo_bloods.back().spawn_tick = tick;
+			wake_after(chunk.zindo_bloods.back().first_wake(), { WAKE_ZINDO_BLOOD, chunk_slot, handle });
+			break;
+		case PLACED_NEURON:
+			chunk.neurons.push_back({});
+			chunk.neurons.back().transform.position.xy = object.position;
+			break;
+		case PLACED_SPIKE:
+			chunk.spikes.push_back({});
+			chunk.spikes.back().transform.position.xy = object.position;
+			break;
+		default:
+			break;
+		}
+	}
+	chunk.is_generated = true;
+	chunk.needs_rendering = true;
+	fill_solidity(chunk);
+	link_halo(chunk);
+}
+
+void game_world::stream_chunks() {
+	center_window(chunk_index_at_world_position(player.transform.position.xy));
+	// Queue the chunks around the player, and around where the player is heading.
+	ne::vector2f velocity = player.transform.position.xy - last_player_position;
+	ne::vector2f ahead = player.transform.position.xy + velocity * (float)stream_lookahead_frames;
+	last_player_position = player.transform.position.xy;
+	request_chunks_around(chunk_index_at_world_position(player.transform.position.xy));
+	request_chunks_around(chunk_index_at_world_position(ahead));
+	// Adopt finished chunks until the frame budget is spent. Chunks that were needed
+	// before the worker got to them have already been generated in at().
+	auto start = std::chrono::steady_clock::now();
+	while (auto generation = worker->take()) {
+		world_chunk* chunk = slot(generation->index.x, generation->index.y);
+		if (chunk && !chunk->is_generated) {
+			if (cache) {
+				cache->store(*generation);
+			}
+			apply(*generation);
+		}
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+		if (elapsed.count() > generation_budget_us) {
+			break;
+		}
+	}
+}
+
+void game_world::center_window(const ne::vector2i& index) {
+	ne::vector2i origin = { index.x - window_size / 2, index.y - window_size / 2 };
+	if (origin == window_origin) {
+		return;
+	}
+	window_origin = origin;
+	for (auto& chunk : chunks) {
+		if (chunk.is_resident && !is_inside_window(chunk.index.x, chunk.index.y)) {
+			evict(chunk);
+		}
+	}
+}
+
+void game_world::evict(world_chunk& chunk) {
+	if (!chunk.is_resident) {
+		return;
+	}
+	write_back(chunk);
+	unlink_halo(chunk);
+	chunk.unload();
+	fill_solidity(chunk);
+}
+
+void game_world::write_back(world_chunk& chunk) {
+	if (!chunk.is_resident || !chunk.is_generated || !chunk.is_modified) {
+		return;
+	}
+	chunk_generation generation;
+	generation.index = chunk.index;
+	chunk.tiles.copy_to(generation.tiles);
+	auto place = [&](const game_object& object, int type) -> placed_object& {
+		generation.objects.push_back({});
+		generation.objects.back().type = type;
+		generation.objects.back().position = object.transform.position.xy;
+		return generation.objects.back();
+	};
+	for (auto& pimple : chunk.pimple_enemies) {
+		place(pimple, PLACED_PIMPLE);
+	}
+	for (auto& artery : chunk.arteries) {
+		placed_object& placed = place(artery, PLACED_ARTERY);
+		placed.variant = artery.type;
+		placed.flipped = artery.is_flipped;
+	}
+	for (auto& zindo_blood : chunk.zindo_bloods) {
+		place(zindo_blood, PLACED_ZINDO_BLOOD);
+	}
+	for (auto& neuron : chunk.neurons) {
+		place(neuron, PLACED_NEURON);
+	}
+	for (auto& spike : chunk.spikes) {
+		place(spike, PLACED_SPIKE);
+	}
+	// Slime tiles are rebuilt from the tile types when the chunk is loaded.
+	if (!damaged_chunks->store(generation)) {
+		NE_WARNING("Failed to cache chunk " << chunk.index);
+	}
+	chunk.is_modified = false;
+}
+
+bool game_world::load_cached(const ne::vector2i& index, chunk_generation& generation) {
+	// Damage done in this session comes before the chunk as it was generated.
+	if (damaged_chunks->load(index, generation)) {
+		return true;
+	}
+	return cache && cache->load(index, generation);
+}
+
+void game_world::mark_modified(const ne::vector2i& index) {
+	if (!is_inside_window(index.x, index.y)) {
+		return;
+	}
+	world_chunk* chunk = slot(index.x, index.y);
+	if (chunk && chunk->is_generated) {
+		chunk->is_modified = true;
+	}
+}
+
+void game_world::request_chunks_around(const ne::vector2i& index) {
+	chunk_generation cached;
+	for (int y = index.y - stream_radius; y <= index.y + stream_radius; y++) {
+		for (int x = index.x - stream_radius; x <= index.x + stream_radius; x++) {
+			world_chunk* chunk = slot(x, y);
+			if (!chunk || chunk->is_generated || chunk->is_requested) {
+				continue;
+			}
+			// Cached chunks are only a copy away, so they skip the worker.
+			if (load_cached(chunk->index, cached)) {
+				apply(cached);
+			} else {
+				chunk->is_requested = worker->request(chunk->index);
+			}
+		}
+	}
+}
+
 void game_world::spawn_objects(world_chunk& chunk) {
-	if (blood_enemies.size() < 10) {
-		int x = -1;
-		int y = -1;
-		do {
-			x = ne::random_int(0, world_chunk::tiles_per_row - 1);
-			y = ne::random_int(0, world_chunk::tiles_per_column - 1);
-		} while (chunk.tiles[y * world_chunk::tiles_per_row + x].type == TILE_WALL);
-		ne::vector2f position = chunk.transform.position.xy;
-		position.x += (float)x * (float)world_chunk::tile_pixel_size;
-		position.y += (float)y * (float)world_chunk::tile_pixel_size;
+	ne::vector2f position;
+	if (blood_enemies.size() < 10 && find_free_tile(chunk, position)) {
 		if (player.transform.distance_to(position) > 128.0f) {
 			blood_enemies.push_back({});
 			blood_enemies.back().transform.position.xy = position;
 		}
 	}
-	if (worm_enemies.size() < 5) {
-		int x = -1;
-		int y = -1;
-		do {
-			x = ne::random_int(0, world_chunk::tiles_per_row - 1);
-			y = ne::random_int(0, world_chunk::tiles_per_column - 1);
-		} while (chunk.tiles[y * world_chunk::tiles_per_row + x].type == TILE_WALL);
-		ne::vector2f position = chunk.transform.position.xy;
-		position.x += (float)x * (float)world_chunk::tile_pixel_size;
-		position.y += (float)y * (float)world_chunk::tile_pixel_size;
+	if (worm_enemies.count() < 5 && find_free_tile(chunk, position)) {
 		if (player.transform.distance_to(position) > 128.0f) {
-			worm_enemies.push_back({});
-			worm_enemies.back().transform.position.xy = position;
-		}
-	}
-	if (slime_queens.size() < 2) {
-		int x = -1;
-		int y = -1;
-		do {
-			x = ne::random_int(0, world_chunk::tiles_per_row - 1);
-			y = ne::random_int(0, world_chunk::tiles_per_column - 1);
-		} while (chunk.tiles[y * world_chunk::tiles_per_row + x].type == TILE_WALL);
-		ne::vector2f position = chunk.transform.position.xy;
-		position.x += (float)x * (float)world_chunk::tile_pixel_size;
-		position.y += (float)y * (float)world_chunk::tile_pixel_size;
+			worm_enemies.add(position);
+		}
+	}
+	if (slime_queens.size() < 2 && find_free_tile(chunk, position)) {
 		if (player.transform.distance_to(position) > 128.0f) {
-			slime_queens.push_back({});
+			entity_handle handle = slime_queens.push_back({});
 			slime_queens.back().transform.position.xy = position;
+			wake_after(slime_queens.back().first_wake(), { WAKE_SLIME_QUEEN, -1, handle });
 		}
 	}
-	if (viruses.size() < 2) {
-		int x = -1;
-		int y = -1;
-		do {
-			x = ne::random_int(0, world_chunk::tiles_per_row - 1);
-			y = ne::random_int(0, world_chunk::tiles_per_column - 1);
-		} while (chunk.tiles[y * world_chunk::tiles_per_row + x].type == TILE_WALL);
-		ne::vector2f position = chunk.transform.position.xy;
-		position.x += (float)x * (float)world_chunk::tile_pixel_size;
-		position.y += (float)y * (float)world_chunk::tile_pixel_size;
+	if (viruses.size() < 2 && find_free_tile(chunk, position)) {
 		if (player.transform.distance_to(position) > 128.0f) {
-			viruses.push_back({});
+			entity_handle handle = viruses.push_back({});
 			viruses.back().transform.position.xy = position;
+			wake_after(viruses.back().first_wake(), { WAKE_VIRUS, -1, handle });
 		}
 	}
 	return;
-	if (eye_bosses.size() < 1) {
-		int x = -1;
-		int y = -1;
-		do {
-			x = ne::random_int(0, world_chunk::tiles_per_row - 1);
-			y = ne::random_int(0, world_chunk::tiles_per_column - 1);
-		} while (chunk.tiles[y * world_chunk::tiles_per_row + x].type == TILE_WALL);
-		ne::vector2f position = chunk.transform.position.xy;
-		position.x += (float)x * (float)world_chunk::tile_pixel_size;
-		position.y += (float)y * (float)world_chunk::tile_pixel_size;
+	if (eye_bosses.size() < 1 && find_free_tile(chunk, position)) {
 		if (player.transform.distance_to(position) > 128.0f) {
 			eye_bosses.push_back({});
 			eye_bosses.back().transform.position.xy = position;
@@ -369,77 +641,93 @@ void game_world::spawn_objects(world_chunk& chunk) {
 }
 
 void game_world::update() {
+	tick++;
+	store_previous_positions();
 	player.update(this);
+	stream_chunks();
+	if (game) {
+		simulation_view.position.xy = game->camera.xy();
+		simulation_view.scale.xy = game->camera.size();
+	}
+	find_active_chunks();
+	wake_due();
+	// The parallel phases only write to their own entities. Spawns and deaths are done after, in order.
+	jobs->parallel_for(blood_enemies.size(), 16, [this](int first, int last) {
+		for (int i = first; i < last; i++) {
+			if (is_simulated_now(blood_enemies[i], i)) {
+				blood_enemies[i].update(this);
+			}
+		}
+	});
 	for (int i = 0; i < (int)blood_enemies.size(); i++) {
 		auto& blood = blood_enemies[i];
-		blood.update(this);
 		if (blood.transform.distance_to(player.transform) > 512.0f) {
-			blood_enemies.erase(blood_enemies.begin() + i);
+			blood_enemies.remove_at(i);
 			i--;
 		}
 	}
-	for (auto& pimple : pimple_enemies) {
-		pimple.update(this);
-	}
 	for (int i = 0; i < (int)slime_queens.size(); i++) {
 		auto& slime_queen = slime_queens[i];
-		slime_queen.update(this);
+		if (is_simulated_now(slime_queen, i)) {
+			slime_queen.update(this);
+		}
 		if (player.transform.collides_with(slime_queen.transform)) {
 			player.hurt(1);
 		}
 		if (slime_queen.transform.distance_to(player.transform) > 512.0f) {
-			slime_queens.erase(slime_queens.begin() + i);
+			slime_queens.remove_at(i);
 			i--;
 		}
 	}
-	for (int i = 0; i < (int)worm_enemies.size(); i++) {
-		auto& worm = worm_enemies[i];
-		worm.update(this);
-		if (player.transform.collides_with(worm.transform)) {
+	jobs->parallel_for(worm_enemies.count(), 256, [this](int first, int last) {
+		worm_enemies.update(this, first, last);
+	});
+	for (int i = 0; i < worm_enemies.count(); i++) {
+		ne::transform3f worm = worm_enemies.transform(i);
+		if (player.transform.collides_with(worm)) {
 			player.hurt(1);
 		}
-		if (worm.transform.distance_to(player.transform) > 512.0f) {
-			worm_enemies.erase(worm_enemies.begin() + i);
+		if (worm.distance_to(player.transform) > 512.0f) {
+			worm_enemies.remove(i);
 			i--;
 		}
 	}
-	for (int i = 0; i < (int)slime_enemies.size(); i++) {
-		auto& slime = slime_enemies[i];
-		slime.update(this);
-		if (player.transform.collides_with(slime.transform)) {
+	jobs->parallel_for(slime_enemies.count(), 256, [this](int first, int last) {
+		slime_enemies.update(this, first, last);
+	});
+	for (int i = 0; i < slime_enemies.count(); i++) {
+		ne::transform3f slime = slime_enemies.transform(i);
+		if (player.transform.collides_with(slime)) {
 			player.hurt(1);
 		}
-		if (slime.transform.distance_to(player.transform) > 512.0f) {
-			slime_enemies.erase(slime_enemies.begin() + i);
+		if (slime.distance_to(player.transform) > 512.0f) {
+			slime_enemies.remove(i);
 			i--;
 		}
 	}
-	for (auto& spike : spikes) {
-		spike.update(this);
-		if (player.transform.collides_with(spike.transform)) {
-			player.hurt(1);
+	// Placed objects have nothing to update. Pimples and zindo bloods act when they are woken.
+	for_each_generated_chunk(first_active_chunk, last_active_chunk, [this](world_chunk& chunk) {
+		for (auto& spike : chunk.spikes) {
+			if (player.transform.collides_with(spike.transform)) {
+				player.hurt(1);
+			}
 		}
-	}
-	for (auto& artery : arteries) {
-		artery.update(this);
-	}
-	for (auto& zindo_blood : zindo_bloods) {
-		zindo_blood.update(this);
-	}
+		for (auto& neuron : chunk.neurons) {
+			if (player.transform.collides_with(neuron.transform)) {
+				player.hurt(1);
+			}
+		}
+	});
 	for (int i = 0; i < (int)viruses.size(); i++) {
 		auto& virus = viruses[i];
-		virus.update(this);
+		if (is_simulated_now(virus, i)) {
+			virus.update(this);
+		}
 		if (virus.transform.distance_to(player.transform) > 512.0f) {
-			viruses.erase(viruses.begin() + i);
+			viruses.remove_at(i);
 			i--;
 		}
 	}
-	for (auto& neuron : neurons) {
-		neuron.update(this);
-		if (player.transform.collides_with(neuron.transform)) {
-			player.hurt(1);
-		}
-	}
 	for (int i = 0; i < (int)eye_bosses.size(); i++) {
 		auto& eye_boss = eye_bosses[i];
 		eye_boss.update(this);
@@ -447,7 +735,7 @@ void game_world::update() {
 			player.hurt(1);
 		}
 		if (eye_boss.transform.distance_to(player.transform) > 512.0f) {
-			eye_bosses.erase(eye_bosses.begin() + i);
+			eye_bosses.remove_at(i);
 			i--;
 		}
 	}
@@ -459,6 +747,7 @@ void game_world::update() {
 	world_chunk* player_chunk = chunk_at_world_position(player.transform.position.xy);
 	if (player_chunk) {
 		auto neighbours = neighbour_chunks(player_chunk->index.x, player_chunk->index.y);
+		generate(neighbours);
 		for (auto& neighbour : neighbours) {
 			if (neighbour) {
 				spawn_objects(*neighbour);
@@ -466,390 +755,457 @@ void game_world::update() {
 		}
 	}
 
-	for (int i = 0; i < (int)bullets.size(); i++) {
-		auto& bullet = bullets[i];
-		bullet.update(this);
-		bool destroy_i = false;
-		if (!bullet.by_player) {
-			if (bullet.transform.collides_with(player.transform)) {
-				player.hurt(bullet.attack());
-				destroy_i = true;
-				bullet.has_hit_wall = false; // just a quickfix to avoid bullets breaking wall
-			}
-		} else {
-			// WARNING: TERRIBLE CODE AHEAD. Deadline approaching...
-			bool cont = false;
-			for (int j = 0; j < (int)worm_enemies.size(); j++) {
-				enemy_chaser_object& worm = worm_enemies[j];
-				if (bullet.transform.collides_with(worm.transform)) {
-					worm.hurt(bullet.attack());
-					if (worm.hearts < 1) {
-						player.score += 5;
-						worm_enemies.erase(worm_enemies.begin() + j);
-						audio.bullet[0].play(20);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)slime_enemies.size(); j++) {
-				enemy_chaser_object& slime = slime_enemies[j];
-				if (bullet.transform.collides_with(slime.transform)) {
-					slime.hurt(bullet.attack());
-					if (slime.hearts < 1) {
-						player.score += 5;
-						slime_enemies.erase(slime_enemies.begin() + j);
-						audio.bullet[0].play(20);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)slime_queens.size(); j++) {
-				enemy_slime_queen_object& slime_queen = slime_queens[j];
-				if (bullet.transform.collides_with(slime_queen.transform)) {
-					slime_queen.hurt(bullet.attack());
-					if (slime_queen.hearts < 1) {
-						player.score += 200;
-						slime_queen.explode(this);
-						shotguns.push_back({});
-						shotguns.back().transform.position.xy = slime_queen.transform.position.xy + slime_queen.transform.scale.xy / 2.0f;
-						slime_queens.erase(slime_queens.begin() + j);
-						audio.bullet[0].play(20);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)viruses.size(); j++) {
-				virus_object& virus = viruses[j];
-				if (bullet.transform.collides_with(virus.transform)) {
-					virus.hurt(bullet.attack());
-					if (virus.hearts < 1) {
-						player.score += 100;
-						if (ne::random_chance(0.75f)) {
-							flamethrowers.push_back({});
-							flamethrowers.back().transform.position.xy = virus.transform.position.xy + virus.transform.scale.xy / 2.0f;
-						}
-						audio.bullet[0].play(20);
-						viruses.erase(viruses.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)zindo_bloods.size(); j++) {
-				zindo_blood_object& zindo_blood = zindo_bloods[j];
-				if (bullet.transform.collides_with(zindo_blood.transform)) {
-					zindo_blood.hurt(bullet.attack());
-					if (zindo_blood.hearts < 1) {
-						player.score += 50;
-						if (ne::random_chance(0.2f)) {
-							flamethrowers.push_back({});
-							flamethrowers.back().transform.position.xy = zindo_blood.transform.position.xy + zindo_blood.transform.scale.xy / 2.0f;
-						}
-						audio.bullet[0].play(20);
-						zindo_bloods.erase(zindo_bloods.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)arteries.size(); j++) {
-				artery_object& artery = arteries[j];
-				if (bullet.transform.collides_with(artery.transform)) {
-					artery.hurt(bullet.attack());
-					if (artery.hearts < 1) {
-						player.score += 5;
-						audio.bullet[0].play(20);
-						arteries.erase(arteries.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)pimple_enemies.size(); j++) {
-				enemy_pimple_object& pimple = pimple_enemies[j];
-				if (bullet.transform.collides_with(pimple.transform)) {
-					pimple.hurt(bullet.attack());
-					if (pimple.hearts < 1) {
-						player.score += 50;
-						if (ne::random_chance(0.2f)) {
-							shotguns.push_back({});
-							shotguns.back().transform.position.xy = pimple.transform.position.xy + pimple.transform.scale.xy / 2.0f;
-						}
-						audio.bullet[0].play(20);
-						pimple_enemies.erase(pimple_enemies.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)neurons.size(); j++) {
-				neuron_object& neuron = neurons[j];
-				if (bullet.transform.collides_with(neuron.transform)) {
-					neuron.hurt(bullet.attack());
-					if (neuron.hearts < 1) {
-						player.score += 25;
-						if (ne::random_chance(0.2f)) {
-							shotguns.push_back({});
-							shotguns.back().transform.position.xy = neuron.transform.position.xy;
-						}
-						audio.bullet[0].play(20);
-						neurons.erase(neurons.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
-			}
-			if (cont) {
-				continue;
+	jobs->parallel_for(bullets.slot_count(), 1024, [this](int first, int last) {
+		bullets.update(first, last);
+	});
+	trace_bullets();
+	build_hit_grid();
+	// Each range of bullets gets its own events, which are joined in order.
+	const int detect_grain = 256;
+	int detect_ranges = (bullets.slot_count() + detect_grain - 1) / detect_grain;
+	if ((int)job_hit_events.size() < detect_ranges) {
+		job_hit_events.resize(detect_ranges);
+		job_hit_candidates.resize(detect_ranges);
+	}
+	jobs->parallel_for(bullets.slot_count(), detect_grain, [&](int first, int last) {
+		int range = first / detect_grain;
+		job_hit_events[range].clear();
+		detect_bullet_hits(first, last, job_hit_candidates[range], job_hit_events[range]);
+	});
+	hit_events.clear();
+	for (int range = 0; range < detect_ranges; range++) {
+		hit_events.insert(hit_events.end(), job_hit_events[range].begin(), job_hit_events[range].end());
+	}
+	resolve_bullet_hits(hit_events);
+	remove_dead_targets();
+}
+
+int64 game_world::ticks_from_ms(int64 ms) {
+	return ms * game_state::ticks_per_second / 1000;
+}
+
+void game_world::wake_after(int64 ticks, const wake_call& call) {
+	wakes.schedule(tick + ticks, call);
+}
+
+void game_world::wake_due() {
+	auto schedule_added = [this](chaser_store& chasers, int type) {
+		for (entity_handle handle : chasers.added) {
+			int index = chasers.find(handle);
+			if (index != -1) {
+				wake_after(chasers.first_turn(index), { type, -1, handle });
 			}
-			for (int j = 0; j < (int)blood_enemies.size(); j++) {
-				enemy_blood_object& blood = blood_enemies[j];
-				if (bullet.transform.collides_with(blood.transform)) {
-					blood.hurt(bullet.attack());
-					if (blood.hearts < 1) {
-						player.score += 5;
-						blood_enemies.erase(blood_enemies.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
-				}
+		}
+		chasers.added.clear();
+	};
+	schedule_added(worm_enemies, WAKE_WORM);
+	schedule_added(slime_enemies, WAKE_SLIME);
+	due_wakes.clear();
+	wakes.advance(tick, due_wakes);
+	// Entities that died or were unloaded since they asked are not found, and their wake is dropped.
+	for (const wake_call& call : due_wakes) {
+		auto wake_object = [&](auto& objects) -> int64 {
+			auto* object = objects.get(call.target);
+			return object ? object->wake(this) : -1;
+		};
+		auto wake_placed = [&](auto& objects) -> int64 {
+			auto* object = objects.get(call.target);
+			if (!object) {
+				return -1;
 			}
-			if (cont) {
-				continue;
+			// Outside the active chunks, placed objects sleep on and look again a second later.
+			const ne::vector2i& index = chunks[call.chunk].index;
+			if (index.x < first_active_chunk.x || index.y < first_active_chunk.y || index.x > last_active_chunk.x || index.y > last_active_chunk.y) {
+				return ticks_from_ms(1000);
 			}
-			for (int j = 0; j < (int)spikes.size(); j++) {
-				spike_object& spike = spikes[j];
-				if (bullet.transform.collides_with(spike.transform)) {
-					spike.hurt(bullet.attack());
-					if (spike.hearts < 1) {
-						player.score += 10;
-						spikes.erase(spikes.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
+			return object->wake(this);
+		};
+		auto turn_chaser = [&](chaser_store& chasers) -> int64 {
+			int index = chasers.find(call.target);
+			return index != -1 ? chasers.turn(this, index) : -1;
+		};
+		int64 next = -1;
+		switch (call.type) {
+		case WAKE_PIMPLE: next = wake_placed(chunks[call.chunk].pimple_enemies); break;
+		case WAKE_ZINDO_BLOOD: next = wake_placed(chunks[call.chunk].zindo_bloods); break;
+		case WAKE_SLIME_QUEEN: next = wake_object(slime_queens); break;
+		case WAKE_VIRUS: next = wake_object(viruses); break;
+		case WAKE_WORM: next = turn_chaser(worm_enemies); break;
+		case WAKE_SLIME: next = turn_chaser(slime_enemies); break;
+		default: break;
+		}
+		if (next >= 0) {
+			wake_after(next, call);
+		}
+	}
+}
+
+int game_world::simulation_interval(const ne::vector2f& position) const {
+	if (!game) {
+		return 1;
+	}
+	const ne::vector2f& view = simulation_view.position.xy;
+	const ne::vector2f& size = simulation_view.scale.xy;
+	float outside_x = std::max({ view.x - position.x, position.x - (view.x + size.width), 0.0f });
+	float outside_y = std::max({ view.y - position.y, position.y - (view.y + size.height), 0.0f });
+	float outside = std::max(outside_x, outside_y);
+	if (outside <= (float)full_rate_margin) {
+		return 1;
+	}
+	if (outside <= (float)half_rate_margin) {
+		return 2;
+	}
+	return max_simulation_interval;
+}
+
+int game_world::simulation_steps(const ne::vector2f& position, int phase, int64& simulated_tick) const {
+	if (simulated_tick < 0) {
+		simulated_tick = tick - 1 - phase % max_simulation_interval;
+	}
+	int interval = simulation_interval(position);
+	int64 elapsed = tick - simulated_tick;
+	if (elapsed < interval) {
+		return 0;
+	}
+	simulated_tick = tick;
+	// Ticks that were skipped before coming closer are dropped, so nothing jumps into view.
+	return (int)std::min<int64>(elapsed, interval);
+}
+
+bool game_world::is_simulated_now(game_object& object, int phase) const {
+	object.simulation_steps = simulation_steps(object.transform.position.xy, phase, object.simulated_tick);
+	return object.simulation_steps > 0;
+}
+
+// Hit entries of placed objects have the slot of their chunk above the index in the chunk.
+static const int placed_hit_shift = 16;
+static const int placed_hit_mask = (1 << placed_hit_shift) - 1;
+
+void game_world::build_hit_grid() {
+	auto add_all = [this](int type, const auto& objects) {
+		for (int i = 0; i < (int)objects.size(); i++) {
+			hit_grid.add(type, i, objects[i].transform);
+		}
+	};
+	auto add_placed = [this](int type, int chunk_slot, const auto& objects) {
+		for (int i = 0; i < (int)objects.size(); i++) {
+			hit_grid.add(type, (chunk_slot << placed_hit_shift) | i, objects[i].transform);
+		}
+	};
+	auto add_chasers = [this](int type, const chaser_store& chasers) {
+		for (int i = 0; i < chasers.count(); i++) {
+			hit_grid.add(type, i, chasers.transform(i));
+		}
+	};
+	hit_grid.clear();
+	add_chasers(HIT_WORM, worm_enemies);
+	add_chasers(HIT_SLIME, slime_enemies);
+	add_all(HIT_SLIME_QUEEN, slime_queens);
+	add_all(HIT_VIRUS, viruses);
+	add_all(HIT_BLOOD, blood_enemies);
+	add_all(HIT_EYE_BOSS, eye_bosses);
+	for_each_generated_chunk(first_active_chunk, last_active_chunk, [&](world_chunk& chunk) {
+		int chunk_slot = (int)(&chunk - chunks);
+		add_placed(HIT_ZINDO_BLOOD, chunk_slot, chunk.zindo_bloods);
+		add_placed(HIT_ARTERY, chunk_slot, chunk.arteries);
+		add_placed(HIT_PIMPLE, chunk_slot, chunk.pimple_enemies);
+		add_placed(HIT_NEURON, chunk_slot, chunk.neurons);
+		add_placed(HIT_SPIKE, chunk_slot, chunk.spikes);
+	});
+	hit_grid.build();
+}
+
+chaser_store* game_world::hit_chasers(int type) {
+	switch (type) {
+	case HIT_WORM: return &worm_enemies;
+	case HIT_SLIME: return &slime_enemies;
+	default: return nullptr;
+	}
+}
+
+game_object& game_world::hit_target(const spatial_hash::entry& entry) {
+	world_chunk& chunk = chunks[entry.index >> placed_hit_shift];
+	int placed = entry.index & placed_hit_mask;
+	switch (entry.type) {
+	case HIT_SLIME_QUEEN: return slime_queens[entry.index];
+	case HIT_VIRUS: return viruses[entry.index];
+	case HIT_ZINDO_BLOOD: return chunk.zindo_bloods[placed];
+	case HIT_ARTERY: return chunk.arteries[placed];
+	case HIT_PIMPLE: return chunk.pimple_enemies[placed];
+	case HIT_NEURON: return chunk.neurons[placed];
+	case HIT_BLOOD: return blood_enemies[entry.index];
+	case HIT_SPIKE: return chunk.spikes[placed];
+	default: return eye_bosses[entry.index];
+	}
+}
+
+int game_world::target_hearts(const spatial_hash::entry& entry) {
+	if (chaser_store* chasers = hit_chasers(entry.type)) {
+		return chasers->hearts[entry.index];
+	}
+	return hit_target(entry).hearts;
+}
+
+ne::transform3f game_world::target_transform(const spatial_hash::entry& entry) {
+	if (chaser_store* chasers = hit_chasers(entry.type)) {
+		return chasers->transform(entry.index);
+	}
+	return hit_target(entry).transform;
+}
+
+void game_world::detect_bullet_hits(int first, int last, std::vector<spatial_hash::entry>& candidates, std::vector<hit_event>& events) {
+	for (int i = first; i < last; i++) {
+		if (!bullets.is_active(i)) {
+			continue;
+		}
+		hit_event event;
+		event.bullet = i;
+		event.damage = bullets.attack(i);
+		ne::transform3f bullet = bullets.transform(i);
+		uint8 flags = bullets.flags[i];
+		if (bullets.owners[i] == BULLET_OWNER_PLAYER) {
+			// Every target is tried in order, as one may die to an earlier bullet this frame.
+			hit_grid.query(bullet, candidates);
+			std::sort(candidates.begin(), candidates.end(), [](const spatial_hash::entry& a, const spatial_hash::entry& b) {
+				return a.type < b.type || (a.type == b.type && a.index < b.index);
+			});
+			for (int c = 0; c < (int)candidates.size(); c++) {
+				const spatial_hash::entry& candidate = candidates[c];
+				if (c > 0 && candidate.type == candidates[c - 1].type && candidate.index == candidates[c - 1].index) {
+					continue;
 				}
-			}
-			if (cont) {
-				continue;
-			}
-			for (int j = 0; j < (int)eye_bosses.size(); j++) {
-				eye_boss_object& eye_boss = eye_bosses[j];
-				if (bullet.transform.collides_with(eye_boss.transform)) {
-					eye_boss.hurt(bullet.attack());
-					if (eye_boss.hearts < 1) {
-						player.score += 1000;
-						eye_bosses.erase(eye_bosses.begin() + j);
-					}
-					destroy_i = true;
-					bullet.has_hit_wall = false;
-					cont = true;
-					bullets.erase(bullets.begin() + i);
-					i--;
-					break;
+				if (target_hearts(candidate) < 1 || !bullet.collides_with(target_transform(candidate))) {
+					continue;
 				}
+				event.kind = HIT_EVENT_TARGET;
+				event.target = candidate;
+				events.push_back(event);
 			}
-			if (cont) {
-				continue;
-			}
+		} else if (player.transform.collides_with(bullet)) {
+			// Bullets that hit the player do not break walls.
+			event.kind = HIT_EVENT_PLAYER;
+			events.push_back(event);
+			continue;
 		}
-		if (bullet.has_hit_wall) {
-			ne::vector2f position = bullet.transform.position.xy + bullet.transform.scale.xy / 2.0f;
-			world_chunk* chunk = chunk_at_world_position(position);
-			if (chunk) {
-				auto tile = chunk->tile_at_world_position(position);
-				if (tile.first) {
-					if (tile.first->type == TILE_WALL || tile.first->type == TILE_SLIME) {
-						if (bullet.can_destroy_wall) {
-							tile.first->health -= bullet.attack();
-							if (tile.first->health < 1) {
-								if (tile.first->type == TILE_SLIME) {
-									for (int s = 0; s < (int)chunk->slime_tiles.size(); s++) {
-										if (tile.first == &chunk->tiles[chunk->slime_tiles[s].i]) {
-											chunk->slime_tiles.erase(chunk->slime_tiles.begin() + s);
-											break;
-										}
-									}
-								}
-								tile.first->type = TILE_BG_TOP;
-								chunk->needs_rendering = true;
-								if (tile.second.x == 0) {
-									world_chunk* left = at(chunk->index.x - 1, chunk->index.y);
-									if (left) {
-										left->needs_rendering = true;
-									}
-								} else if (tile.second.x == world_chunk::tiles_per_row - 1) {
-									world_chunk* right = at(chunk->index.x + 1, chunk->index.y);
-									if (right) {
-										right->needs_rendering = true;
-									}
-								}
-								if (tile.second.y == 0) {
-									world_chunk* up = at(chunk->index.x, chunk->index.y - 1);
-									if (up) {
-										up->needs_rendering = true;
-									}
-								} else if (tile.second.y == world_chunk::tiles_per_column - 1) {
-									world_chunk* down = at(chunk->index.x, chunk->index.y + 1);
-									if (down) {
-										down->needs_rendering = true;
-									}
-								}
-								if (bullet.by_player) {
-									player.score++;
-								}
-							}
-						}
-						destroy_i = true;
-					}
-				}
-			}
+		if (flags & BULLET_FLAG_LEFT_WINDOW) {
+			event.kind = HIT_EVENT_LEFT_WINDOW;
+			events.push_back(event);
+		} else if (flags & BULLET_FLAG_HIT_WALL) {
+			event.kind = HIT_EVENT_WALL;
+			events.push_back(event);
 		}
-		if (destroy_i) {
-			bullets.erase(bullets.begin() + i);
-			i--;
+	}
+}
+
+void game_world::resolve_bullet_hits(const std::vector<hit_event>& events) {
+	// Dead targets are removed after all bullets are done, so the indices stay valid.
+	for (int e = 0; e < (int)events.size(); e++) {
+		const hit_event& event = events[e];
+		bool is_spent = false;
+		switch (event.kind) {
+		case HIT_EVENT_TARGET:
+			is_spent = resolve_target_hit(event);
+			break;
+		case HIT_EVENT_PLAYER:
+			player.hurt(event.damage);
+			is_spent = true;
+			break;
+		case HIT_EVENT_WALL:
+			is_spent = resolve_wall_hit(event);
+			break;
+		case HIT_EVENT_LEFT_WINDOW:
+			is_spent = true;
+			break;
+		default:
+			break;
+		}
+		if (!is_spent) {
+			continue;
+		}
+		bullets.despawn(event.bullet);
+		while (e + 1 < (int)events.size() && events[e + 1].bullet == event.bullet) {
+			e++;
 		}
 	}
 }
 
-void game_world::draw(const ne::transform3f& view) {
-	textures.tiles.bind();
-	ne::shader::set_color(1.0f);
-	ne::vector2f chunk_pixel_size = { (float)world_chunk::pixel_width, (float)world_chunk::pixel_height };
-	// todo: use camera position and turn into chunk indices
-	for (auto& chunk : chunks) {
-		if (view.collides_with(chunk.transform.position.xy, chunk_pixel_size)) {
-			chunk.draw_tiles();
+// What the player gets for killing each type of target.
+struct hit_reward {
+	int score = 0;
+	int drop = -1;
+	float drop_chance = 0.0f;
+	bool drops_at_center = true;
+	bool plays_sound = false;
+	bool is_placed = false;
+};
+
+static const hit_reward hit_rewards[HIT_TYPES] = {
+	{ 5, -1, 0.0f, true, true, false }, // HIT_WORM
+	{ 5, -1, 0.0f, true, true, false }, // HIT_SLIME
+	{ 200, ITEM_SHOTGUN, 1.0f, true, true, false }, // HIT_SLIME_QUEEN
+	{ 100, ITEM_FLAMETHROWER, 0.75f, true, true, false }, // HIT_VIRUS
+	{ 50, ITEM_FLAMETHROWER, 0.2f, true, true, true }, // HIT_ZINDO_BLOOD
+	{ 5, -1, 0.0f, true, true, true }, // HIT_ARTERY
+	{ 50, ITEM_SHOTGUN, 0.2f, true, true, true }, // HIT_PIMPLE
+	{ 25, ITEM_SHOTGUN, 0.2f, false, true, true }, // HIT_NEURON
+	{ 5, -1, 0.0f, true, false, false }, // HIT_BLOOD
+	{ 10, -1, 0.0f, true, false, true }, // HIT_SPIKE
+	{ 1000, -1, 0.0f, true, false, false } // HIT_EYE_BOSS
+};
+
+bool game_world::resolve_target_hit(const hit_event& event) {
+	const spatial_hash::entry& target = event.target;
+	// Killed by an earlier bullet this frame, so this one flies on to the next target.
+	if (target_hearts(target) < 1) {
+		return false;
+	}
+	ne::transform3f transform = target_transform(target);
+	chaser_store* chasers = hit_chasers(target.type);
+	if (chasers) {
+		chasers->hurt(target.index, event.damage);
+	} else {
+		hit_target(target).hurt(event.damage);
+	}
+	if (target_hearts(target) >= 1) {
+		return true;
+	}
+	const hit_reward& reward = hit_rewards[target.type];
+	player.score += reward.score;
+	if (target.type == HIT_SLIME_QUEEN) {
+		slime_queens[target.index].explode(this);
+	}
+	if (reward.drop != -1 && (reward.drop_chance >= 1.0f || ne::random_chance(reward.drop_chance))) {
+		drop_item(reward.drop, reward.drops_at_center ? transform.position.xy + transform.scale.xy / 2.0f : transform.position.xy);
+	}
+	if (reward.plays_sound) {
+		audio.bullet[0].play(20);
+	}
+	if (reward.is_placed) {
+		chunks[target.index >> placed_hit_shift].is_modified = true;
+	}
+	return true;
+}
+
+bool game_world::resolve_wall_hit(const hit_event& event) {
+	// The trace found the tile, so only the slot has to be looked up.
+	ne::vector2i tile = bullets.hit_tiles[event.bullet];
+	world_chunk* chunk = &chunks[slot_index(tile.x >> world_chunk::tiles_per_row_shift, tile.y >> world_chunk::tiles_per_row_shift)];
+	ne::vector2i local = { tile.x & (world_chunk::tiles_per_row - 1), tile.y & (world_chunk::tiles_per_column - 1) };
+	int tile_i = local.y * world_chunk::tiles_per_row + local.x;
+	int type = chunk->tiles.get(tile_i).type;
+	// Another bullet may have destroyed the tile earlier this frame.
+	if (type != TILE_WALL && type != TILE_SLIME) {
+		return false;
+	}
+	if (!(bullets.flags[event.bullet] & BULLET_FLAG_DESTROYS_WALLS)) {
+		return true;
+	}
+	tile_data* damaged = chunk->tiles.edit(tile_i);
+	damaged->health -= event.damage;
+	chunk->is_modified = true;
+	if (damaged->health >= 1) {
+		return true;
+	}
+	if (damaged->type == TILE_SLIME) {
+		for (int s = 0; s < (int)chunk->slime_tiles.size(); s++) {
+			if (chunk->slime_tiles[s].i == tile_i) {
+				chunk->slime_tiles.erase(chunk->slime_tiles.begin() + s);
+				break;
+			}
 		}
 	}
+	damaged->type = TILE_BG_TOP;
+	set_solidity(*chunk, tile_i);
+	chunk->needs_rendering = true;
+	update_halo_tile(*chunk, tile_i);
+	if (bullets.owners[event.bullet] == BULLET_OWNER_PLAYER) {
+		player.score++;
+	}
+	return true;
+}
+
+void game_world::drop_item(int type, const ne::vector2f& position) {
+	entity_vector<item_object>* items = nullptr;
+	switch (type) {
+	case ITEM_PILL: items = &pills; break;
+	case ITEM_INJECTION: items = &injections; break;
+	case ITEM_SHOTGUN: items = &shotguns; break;
+	case ITEM_FLAMETHROWER: items = &flamethrowers; break;
+	default: return;
+	}
+	items->push_back({});
+	items->back().transform.position.xy = position;
+}
+
+void game_world::remove_dead_targets() {
+	auto remove_dead = [](auto& objects) {
+		objects.remove_if([](const game_object& object) {
+			return object.hearts < 1;
+		});
+	};
+	worm_enemies.remove_dead();
+	slime_enemies.remove_dead();
+	remove_dead(slime_queens);
+	remove_dead(viruses);
+	remove_dead(blood_enemies);
+	remove_dead(eye_bosses);
+	for_each_generated_chunk(first_active_chunk, last_active_chunk, [&](world_chunk& chunk) {
+		remove_dead(chunk.zindo_bloods);
+		remove_dead(chunk.arteries);
+		remove_dead(chunk.pimple_enemies);
+		remove_dead(chunk.neurons);
+		remove_dead(chunk.spikes);
+	});
+}
+
+void game_world::draw(const ne::transform3f& view, float alpha) {
+	interpolate_positions(alpha);
+	textures.tiles.bind();
+	ne::shader::set_color(1.0f);
+	ne::vector2i first_chunk = chunk_index_at_world_position(view.position.xy);
+	ne::vector2i last_chunk = chunk_index_at_world_position(view.position.xy + view.scale.xy);
+	// Only chunks that update() has generated are drawn, so drawing never changes the world.
+	for_each_generated_chunk(first_chunk, last_chunk, [](world_chunk& chunk) {
+		chunk.draw_tiles();
+	});
 	animated_quad().bind();
 	textures.slime_drop.bind();
-	for (auto& chunk : chunks) {
-		if (view.collides_with(chunk.transform.position.xy, chunk_pixel_size)) {
-			chunk.draw_slime();
-		}
-	}
+	for_each_generated_chunk(first_chunk, last_chunk, [](world_chunk& chunk) {
+		chunk.draw_slime();
+	});
+	// Placed objects can reach over the edge of their chunk.
+	ne::vector2f reach = { (float)placed_object_margin, (float)placed_object_margin };
+	ne::vector2i first_placed_chunk = chunk_index_at_world_position(view.position.xy - reach);
+	auto draw_placed = [&](auto member) {
+		for_each_generated_chunk(first_placed_chunk, last_chunk, [&](world_chunk& chunk) {
+			for (auto& object : chunk.*member) {
+				if (object.transform.collides_with(view)) {
+					object.draw();
+				}
+			}
+		});
+	};
 	textures.pimple.bind();
-	for (auto& pimple : pimple_enemies) {
-		if (!pimple.transform.collides_with(view)) {
-			continue;
-		}
-		pimple.draw();
-	}
+	draw_placed(&world_chunk::pimple_enemies);
 	textures.worm.bind();
-	for (auto& worm : worm_enemies) {
-		worm.draw();
-	}
+	worm_enemies.draw(alpha);
 	for (auto& virus : viruses) {
 		virus.draw();
 	}
 	still_quad().bind();
 	textures.bullet.bind();
-	for (auto& bullet : bullets) {
-		if (bullet.type != BULLET_NORMAL || !bullet.transform.collides_with(view)) {
-			continue;
-		}
-		bullet.draw();
-	}
+	bullets.draw(BULLET_NORMAL, view, alpha);
 	textures.laser.bind();
-	for (auto& bullet : bullets) {
-		if (bullet.type != BULLET_LASER || !bullet.transform.collides_with(view)) {
-			continue;
-		}
-		bullet.draw();
-	}
+	bullets.draw(BULLET_LASER, view, alpha);
 	textures.shotgun_bullet.bind();
-	for (auto& bullet : bullets) {
-		if (bullet.type != BULLET_SHOTGUN || !bullet.transform.collides_with(view)) {
-			continue;
-		}
-		bullet.draw();
-	}
+	bullets.draw(BULLET_SHOTGUN, view, alpha);
 	textures.flame_bullet.bind();
-	for (auto& bullet : bullets) {
-		if (bullet.type != BULLET_FLAME || !bullet.transform.collides_with(view)) {
-			continue;
-		}
-		bullet.draw();
-	}
+	bullets.draw(BULLET_FLAME, view, alpha);
 	animated_quad().bind();
 	textures.artery.bind();
-	for (auto& artery : arteries) {
-		if (!artery.transform.collides_with(view)) {
-			continue;
-		}
-		artery.draw();
-	}
+	draw_placed(&world_chunk::arteries);
 	textures.blood_bullet.bind();
-	for (auto& bullet : bullets) {
-		if (bullet.type != BULLET_BLOOD || !bullet.transform.collides_with(view)) {
-			continue;
-		}
-		bullet.draw();
-	}
+	bullets.draw(BULLET_BLOOD, view, alpha);
 	still_quad().bind();
 	player.draw();
 	textures.blood.bind();
@@ -861,9 +1217,7 @@ void game_world::draw(const ne::transform3f& view) {
 		slime_queen.draw();
 	}
 	textures.slime.bind();
-	for (auto& slime : slime_enemies) {
-		slime.draw();
-	}
+	slime_enemies.draw(alpha);
 	textures.pill.bind();
 	for (auto& pill : pills) {
 		pill.draw();
@@ -881,30 +1235,22 @@ void game_world::draw(const ne::transform3f& view) {
 		flamethrower.draw();
 	}
 	textures.neuron.bind();
-	for (auto& neuron : neurons) {
-		if (!neuron.transform.collides_with(view)) {
-			continue;
-		}
-		neuron.draw();
-	}
+	draw_placed(&world_chunk::neurons);
 	for (auto& eye_boss : eye_bosses) {
 		eye_boss.draw();
 	}
 	textures.spike.bind();
 	animated_quad().bind();
-	for (auto& spike : spikes) {
-		if (!spike.transform.collides_with(view)) {
-			continue;
-		}
-		spike.draw();
-	}
+	draw_placed(&world_chunk::spikes);
 	textures.zindo_blood.bind();
-	for (auto& zindo_blood : zindo_bloods) {
-		if (!zindo_blood.transform.collides_with(view)) {
-			continue;
+	for_each_generated_chunk(first_placed_chunk, last_chunk, [&](world_chunk& chunk) {
+		for (auto& zindo_blood : chunk.zindo_bloods) {
+			if (zindo_blood.transform.collides_with(view)) {
+				zindo_blood.animate(tick);
+				zindo_blood.draw();
+			}
 		}
-		zindo_blood.draw();
-	}
+	});
 	still_quad().bind();
 	// Draw cursor:
 	ne::vector2i mouse = game->camera.mouse().to<int>();
@@ -916,13 +1262,120 @@ void game_world::draw(const ne::transform3f& view) {
 	ne::shader::set_transform(&cursor);
 	textures.cursor.bind();
 	still_quad().draw();
+	restore_positions();
 }
 
-world_chunk* game_world::at(int x, int y) {
-	if (x < 0 || y < 0 || x >= chunks_per_row || y >= chunks_per_column) {
+template<typename Function>
+void game_world::for_each_object_list(Function function) {
+	function(blood_enemies);
+	function(slime_queens);
+	function(pills);
+	function(injections);
+	function(shotguns);
+	function(flamethrowers);
+	function(viruses);
+	function(eye_bosses);
+}
+
+template<typename Function>
+void game_world::for_each_generated_chunk(const ne::vector2i& first, const ne::vector2i& last, Function function) {
+	for (int y = first.y; y <= last.y; y++) {
+		for (int x = first.x; x <= last.x; x++) {
+			if (is_generated_in_window(x, y)) {
+				function(chunks[slot_index(x, y)]);
+			}
+		}
+	}
+}
+
+void game_world::find_active_chunks() {
+	ne::vector2i center = chunk_index_at_world_position(player.transform.position.xy);
+	first_active_chunk = { center.x - 1, center.y - 1 };
+	last_active_chunk = { center.x + 1, center.y + 1 };
+	if (!game) {
+		return;
+	}
+	ne::vector2f margin = { (float)placed_object_margin, (float)placed_object_margin };
+	ne::vector2i first = chunk_index_at_world_position(simulation_view.position.xy - margin);
+	ne::vector2i last = chunk_index_at_world_position(simulation_view.position.xy + simulation_view.scale.xy + margin);
+	first_active_chunk = { std::min(first.x, first_active_chunk.x), std::min(first.y, first_active_chunk.y) };
+	last_active_chunk = { std::max(last.x, last_active_chunk.x), std::max(last.y, last_active_chunk.y) };
+}
+
+void game_world::store_previous_positions() {
+	player.previous_position = player.transform.position.xy;
+	player.previous_tick = tick;
+	for_each_object_list([this](auto& objects) {
+		for (auto& object : objects) {
+			object.previous_position = object.transform.position.xy;
+			object.previous_tick = tick;
+		}
+	});
+}
+
+void game_world::interpolate_positions(float alpha) {
+	// The simulated positions are put back by restore_positions() once everything is drawn.
+	auto interpolate_object = [&](game_object& object) {
+		simulated_positions.push_back(object.transform.position.xy);
+		if (object.previous_tick == tick) {
+			object.transform.position.xy = interpolate(object.previous_position, object.transform.position.xy, alpha);
+		}
+	};
+	simulated_positions.clear();
+	interpolate_object(player);
+	for_each_object_list([&](auto& objects) {
+		for (auto& object : objects) {
+			interpolate_object(object);
+		}
+	});
+}
+
+void game_world::restore_positions() {
+	int i = 0;
+	player.transform.position.xy = simulated_positions[i++];
+	for_each_object_list([&](auto& objects) {
+		for (auto& object : objects) {
+			object.transform.position.xy = simulated_positions[i++];
+		}
+	});
+}
+
+bool game_world::is_inside_world(int x, int y) const {
+	const ne::vector2i& size = generator.size;
+	if (size.x > 0 && (x < 0 || x >= size.x)) {
+		return false;
+	}
+	if (size.y > 0 && (y < 0 || y >= size.y)) {
+		return false;
+	}
+	return true;
+}
+
+bool game_world::is_inside_window(int x, int y) const {
+	x -= window_origin.x;
+	y -= window_origin.y;
+	return x >= 0 && y >= 0 && x < window_size && y < window_size;
+}
+
+world_chunk* game_world::slot(int x, int y) {
+	if (!is_inside_world(x, y) || !is_inside_window(x, y)) {
 		return nullptr;
 	}
-	return &chunks[y * chunks_per_row + x];
+	// The window is a ring buffer, so a chunk keeps its slot while the window moves.
+	world_chunk& chunk = chunks[slot_index(x, y)];
+	if (!chunk.is_resident || chunk.index != ne::vector2i{ x, y }) {
+		evict(chunk);
+		chunk.load({ x, y });
+	}
+	return &chunk;
+}
+
+world_chunk* game_world::at(int x, int y) {
+	world_chunk* chunk = slot(x, y);
+	if (chunk && !chunk->is_generated) {
+		generate(*chunk);
+	}
+	return chunk;
 }
 
 std::vector<world_chunk*> game_world::neighbour_chunks(int x, int y) {
@@ -938,39 +1391,321 @@ std::vector<world_chunk*> game_world::neighbour_chunks(int x, int y) {
 	return neighbours;
 }
 
+ne::vector2i game_world::chunk_index_at_world_position(const ne::vector2f& position) const {
+	return {
+		(int)std::floor(position.x / (float)world_chunk::pixel_width),
+		(int)std::floor(position.y / (float)world_chunk::pixel_height)
+	};
+}
+
 world_chunk* game_world::chunk_at_world_position(const ne::vector2f& position) {
-	ne::vector2i chunk_index = position.to<int>();
-	chunk_index.x /= world_chunk::pixel_width;
-	chunk_index.y /= world_chunk::pixel_height;
+	ne::vector2i chunk_index = chunk_index_at_world_position(position);
 	return at(chunk_index.x, chunk_index.y);
 }
 
-bool game_world::is_free_at(const ne::vector2f& position) {
-	world_chunk* chunk = chunk_at_world_position(position);
-	if (!chunk) {
+bool game_world::is_free_at(const ne::vector2f& position) const {
+	int x = (int)std::floor(position.x) >> world_chunk::tile_pixel_shift;
+	int y = (int)std::floor(position.y) >> world_chunk::tile_pixel_shift;
+	if (!is_generated_in_window(x >> world_chunk::tiles_per_row_shift, y >> world_chunk::tiles_per_row_shift)) {
 		return false;
 	}
-	auto tile = chunk->tile_at_world_position(position);
-	if (!tile.first) {
-		NE_ERROR("No tile at world position " << position);
-		return false;
+	int bit = (x & (solidity_size - 1));
+	return !((solidity[(y & (solidity_size - 1)) * solidity_words + bit / 64] >> (bit % 64)) & 1);
+}
+
+bool game_world::is_area_free(const ne::vector2f& position, const ne::vector2f& size) {
+	// The right and bottom edges are exclusive, so an area of size zero is a single point.
+	int left = (int)std::floor(position.x);
+	int top = (int)std::floor(position.y);
+	int right = std::max(left, (int)std::ceil(position.x + size.x) - 1) >> world_chunk::tile_pixel_shift;
+	int bottom = std::max(top, (int)std::ceil(position.y + size.y) - 1) >> world_chunk::tile_pixel_shift;
+	left >>= world_chunk::tile_pixel_shift;
+	top >>= world_chunk::tile_pixel_shift;
+	for (int y = top >> world_chunk::tiles_per_row_shift; y <= bottom >> world_chunk::tiles_per_row_shift; y++) {
+		for (int x = left >> world_chunk::tiles_per_row_shift; x <= right >> world_chunk::tiles_per_row_shift; x++) {
+			if (!is_inside_window(x, y) || !at(x, y)) {
+				return false;
+			}
+		}
 	}
-	if (tile.first->type == TILE_WALL) {
-		return false;
+	// Everything is inside the window here, so the area is never wider than the grid.
+	int from = left & (solidity_size - 1);
+	int to = right & (solidity_size - 1);
+	for (int y = top; y <= bottom; y++) {
+		int row = y & (solidity_size - 1);
+		if (from <= to) {
+			if (is_row_solid(row, from, to)) {
+				return false;
+			}
+		} else if (is_row_solid(row, from, solidity_size - 1) || is_row_solid(row, 0, to)) {
+			return false;
+		}
 	}
-	if (tile.first->type == TILE_SLIME) {
-		return false;
+	return true;
+}
+
+ray_hit game_world::trace(const ne::vector2f& from, const ne::vector2f& to) const {
+	// Steps through every tile the segment touches, in order (Amanatides & Woo).
+	ray_hit hit;
+	const float size = (float)world_chunk::tile_pixel_size;
+	const float infinity = std::numeric_limits<float>::infinity();
+	int x = (int)std::floor(from.x) >> world_chunk::tile_pixel_shift;
+	int y = (int)std::floor(from.y) >> world_chunk::tile_pixel_shift;
+	int end_x = (int)std::floor(to.x) >> world_chunk::tile_pixel_shift;
+	int end_y = (int)std::floor(to.y) >> world_chunk::tile_pixel_shift;
+	ne::vector2f delta = to - from;
+	int step_x = (delta.x > 0.0f ? 1 : -1);
+	int step_y = (delta.y > 0.0f ? 1 : -1);
+	float next_x = infinity;
+	float next_y = infinity;
+	float step_time_x = infinity;
+	float step_time_y = infinity;
+	if (delta.x != 0.0f) {
+		next_x = ((float)(delta.x > 0.0f ? x + 1 : x) * size - from.x) / delta.x;
+		step_time_x = size / std::abs(delta.x);
+	}
+	if (delta.y != 0.0f) {
+		next_y = ((float)(delta.y > 0.0f ? y + 1 : y) * size - from.y) / delta.y;
+		step_time_y = size / std::abs(delta.y);
+	}
+	int steps = std::abs(end_x - x) + std::abs(end_y - y);
+	for (int i = 0; i <= steps; i++) {
+		int chunk_x = x >> world_chunk::tiles_per_row_shift;
+		int chunk_y = y >> world_chunk::tiles_per_row_shift;
+		// Never generates. Chunks that are not generated yet end the trace.
+		if (!is_generated_in_window(chunk_x, chunk_y)) {
+			hit.has_left_window = true;
+			return hit;
+		}
+		int bit = x & (solidity_size - 1);
+		if ((solidity[(y & (solidity_size - 1)) * solidity_words + bit / 64] >> (bit % 64)) & 1) {
+			// Bones are solid, but bullets fly past them.
+			const world_chunk& chunk = chunks[slot_index(chunk_x, chunk_y)];
+			int type = chunk.tiles.get((y & (world_chunk::tiles_per_column - 1)) * world_chunk::tiles_per_row + (x & (world_chunk::tiles_per_row - 1))).type;
+			if (type == TILE_WALL || type == TILE_SLIME) {
+				hit.is_blocked = true;
+				hit.tile = { x, y };
+				return hit;
+			}
+		}
+		if (next_x < next_y) {
+			x += step_x;
+			next_x += step_time_x;
+		} else {
+			y += step_y;
+			next_y += step_time_y;
+		}
 	}
-	if (tile.first->extra >= TILE_EX_BONE_BASE_LEFT && tile.first->extra <= TILE_EX_BONE_MID_RIGHT) {
-		return false;
+	return hit;
+}
+
+void game_world::trace_bullets() {
+	for (int i = 0; i < bullets.slot_count(); i++) {
+		if (!bullets.is_active(i)) {
+			continue;
+		}
+		ray_hit hit = trace(bullets.last_centers[i], bullets.positions[i] + bullets.sizes[i] / 2.0f);
+		uint8& flags = bullets.flags[i];
+		flags &= ~(BULLET_FLAG_HIT_WALL | BULLET_FLAG_LEFT_WINDOW);
+		if (hit.is_blocked) {
+			flags |= BULLET_FLAG_HIT_WALL;
+		}
+		if (hit.has_left_window) {
+			flags |= BULLET_FLAG_LEFT_WINDOW;
+		}
+		bullets.hit_tiles[i] = hit.tile;
 	}
-	return true;
 }
 
-bool world_generator::add_bone(world_chunk& chunk, int i) {
+bool game_world::find_free_tile(world_chunk& chunk, ne::vector2f& position) {
+	// Gives up after a few tries, since a chunk can be solid all over.
+	for (int attempt = 0; attempt < 16; attempt++) {
+		int x = ne::random_int(0, world_chunk::tiles_per_row - 1);
+		int y = ne::random_int(0, world_chunk::tiles_per_column - 1);
+		position = chunk.transform.position.xy;
+		position.x += (float)x * (float)world_chunk::tile_pixel_size;
+		position.y += (float)y * (float)world_chunk::tile_pixel_size;
+		if (is_area_free(position, (float)world_chunk::tile_pixel_size)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static const ne::vector2i halo_offsets[4] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+
+void game_world::link_halo(world_chunk& chunk) {
+	for (int side = 0; side < 4; side++) {
+		int x = chunk.index.x + halo_offsets[side].x;
+		int y = chunk.index.y + halo_offsets[side].y;
+		world_chunk* neighbour = (is_generated_in_window(x, y) ? &chunks[slot_index(x, y)] : nullptr);
+		chunk.copy_halo(side, neighbour);
+		if (neighbour) {
+			// Its edge was rendered without this chunk.
+			neighbour->copy_halo(side ^ 1, &chunk);
+			neighbour->needs_rendering = true;
+		}
+	}
+}
+
+void game_world::unlink_halo(world_chunk& chunk) {
+	for (int side = 0; side < 4; side++) {
+		int x = chunk.index.x + halo_offsets[side].x;
+		int y = chunk.index.y + halo_offsets[side].y;
+		if (is_generated_in_window(x, y)) {
+			world_chunk& neighbour = chunks[slot_index(x, y)];
+			neighbour.copy_halo(side ^ 1, nullptr);
+			neighbour.needs_rendering = true;
+		}
+	}
+}
+
+void game_world::update_halo_tile(world_chunk& chunk, int i) {
+	int tile_x = i % world_chunk::tiles_per_row;
+	int tile_y = i / world_chunk::tiles_per_row;
+	const int last = world_chunk::tiles_per_row - 1;
+	for (int side = 0; side < 4; side++) {
+		int along = -1;
+		if ((side == HALO_UP && tile_y == 0) || (side == HALO_DOWN && tile_y == last)) {
+			along = tile_x;
+		} else if ((side == HALO_LEFT && tile_x == 0) || (side == HALO_RIGHT && tile_x == last)) {
+			along = tile_y;
+		}
+		int x = chunk.index.x + halo_offsets[side].x;
+		int y = chunk.index.y + halo_offsets[side].y;
+		if (along != -1 && is_generated_in_window(x, y)) {
+			world_chunk& neighbour = chunks[slot_index(x, y)];
+			neighbour.halo[side ^ 1][along] = chunk.tiles.get(i);
+			neighbour.needs_rendering = true;
+		}
+	}
+}
+
+void game_world::fill_solidity(const world_chunk& chunk) {
+	int grid_x = (chunk.index.x * world_chunk::tiles_per_row) & (solidity_size - 1);
+	int grid_y = (chunk.index.y * world_chunk::tiles_per_column) & (solidity_size - 1);
+	int shift = grid_x % 64;
+	for (int y = 0; y < world_chunk::tiles_per_column; y++) {
+		uint64 bits = 0;
+		if (chunk.is_generated) {
+			for (int x = 0; x < world_chunk::tiles_per_row; x++) {
+				if (is_solid_tile(chunk.tiles.get(y * world_chunk::tiles_per_row + x))) {
+					bits |= 1ull << x;
+				}
+			}
+		}
+		uint64& word = solidity[(grid_y + y) * solidity_words + grid_x / 64];
+		word = (word & ~(0xFFFFFFFFull << shift)) | (bits << shift);
+	}
+}
+
+void game_world::set_solidity(const world_chunk& chunk, int i) {
+	int x = ((chunk.index.x * world_chunk::tiles_per_row) + i % world_chunk::tiles_per_row) & (solidity_size - 1);
+	int y = ((chunk.index.y * world_chunk::tiles_per_column) + i / world_chunk::tiles_per_row) & (solidity_size - 1);
+	uint64& word = solidity[y * solidity_words + x / 64];
+	if (is_solid_tile(chunk.tiles.get(i))) {
+		word |= 1ull << (x % 64);
+	} else {
+		word &= ~(1ull << (x % 64));
+	}
+}
+
+int game_world::slot_index(int x, int y) const {
+	return (y & (window_size - 1)) * window_size + (x & (window_size - 1));
+}
+
+bool game_world::is_generated_in_window(int x, int y) const {
+	// A slot inside the window always holds the chunk with that index, if any.
+	return is_inside_window(x, y) && chunks[slot_index(x, y)].is_generated;
+}
+
+bool game_world::is_row_solid(int row, int from, int to) const {
+	const uint64* words = &solidity[row * solidity_words];
+	for (int i = from / 64; i <= to / 64; i++) {
+		uint64 mask = ~0ull;
+		if (i == from / 64) {
+			mask &= ~0ull << (from % 64);
+		}
+		if (i == to / 64) {
+			mask &= ~0ull >> (63 - to % 64);
+		}
+		if (words[i] & mask) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool is_solid_tile(const tile_data& tile) {
+	if (tile.type == TILE_WALL || tile.type == TILE_SLIME) {
+		return true;
+	}
+	return tile.extra >= TILE_EX_BONE_BASE_LEFT && tile.extra <= TILE_EX_BONE_MID_RIGHT;
+}
+
+void world_generator::set_seed(uint32 seed) {
+	this->seed = seed;
+	noise.seed(seed);
+}
+
+// FNV-1a over the tiles and everything placed in the chunk.
+uint64 chunk_generation::content_hash() const {
+	uint64 hash = 14695981039346656037ull;
+	auto add = [&](const void* data, size_t size) {
+		const uint8* bytes = (const uint8*)data;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+	for (auto& tile : tiles) {
+		add(&tile.type, 1);
+		add(&tile.extra, 1);
+		add(&tile.health, 1);
+	}
+	for (int i : slime_tiles) {
+		add(&i, sizeof(i));
+	}
+	for (auto& object : objects) {
+		int8 flipped = (object.flipped ? 1 : 0);
+		add(&object.type, sizeof(object.type));
+		add(&object.position.x, sizeof(object.position.x));
+		add(&object.position.y, sizeof(object.position.y));
+		add(&object.variant, sizeof(object.variant));
+		add(&flipped, 1);
+	}
+	return hash;
+}
+
+bool world_generator::is_border(const ne::vector2i& index) const {
+	if (size.x > 0 && (index.x == 0 || index.x == size.x - 1)) {
+		return true;
+	}
+	return size.y > 0 && (index.y == 0 || index.y == size.y - 1);
+}
+
+void world_generator::generate(const ne::vector2i& index, chunk_generation& generation) const {
+	generation.index = index;
+	if (is_border(index)) {
+		border(generation);
+	} else {
+		normal(generation);
+	}
+}
+
+void world_generator::generate(const std::vector<ne::vector2i>& indices, std::vector<chunk_generation>& generations, job_system& jobs) const {
+	generations.resize(indices.size());
+	// Each chunk only depends on the seed and its index, and writes to its own slot.
+	jobs.parallel_for((int)indices.size(), 1, [&](int first, int last) {
+		for (int i = first; i < last; i++) {
+			generate(indices[i], generations[i]);
+		}
+	});
+}
+
+bool world_generator::add_bone(chunk_generation& chunk, int i, seeded_random& random) const {
 	int x = i % world_chunk::tiles_per_row;
 	int y = i / world_chunk::tiles_per_row;
-	if (y > 5 && x % 2 != 0 && chunk.tiles[i].type == TILE_WALL && chunk.tiles[i + 1].type == TILE_WALL && ne::random_chance(0.4f)) {
+	if (y > 5 && x % 2 != 0 && i + 1 < world_chunk::total_tiles && chunk.tiles[i].type == TILE_WALL && chunk.tiles[i + 1].type == TILE_WALL && random.chance(0.4f)) {
 		int j = i - world_chunk::tiles_per_row;
 		int k = j - world_chunk::tiles_per_row;
 		int l = k - world_chunk::tiles_per_row;
@@ -980,9 +1715,9 @@ bool world_generator::add_bone(world_chunk& chunk, int i) {
 			int type = 0;
 			int m = l - world_chunk::tiles_per_row;
 			int n = m - world_chunk::tiles_per_row;
-			type += ((chunk.tiles[m].type != TILE_WALL && chunk.tiles[m + 1].type && ne::random_chance(0.5)) ? 1 : 0);
+			type += ((chunk.tiles[m].type != TILE_WALL && chunk.tiles[m + 1].type && random.chance(0.5f)) ? 1 : 0);
 			if (type == 1) {
-				type += ((chunk.tiles[n].type != TILE_WALL && chunk.tiles[n + 1].type && ne::random_chance(0.5)) ? 1 : 0);
+				type += ((chunk.tiles[n].type != TILE_WALL && chunk.tiles[n + 1].type && random.chance(0.5f)) ? 1 : 0);
 			}
 			chunk.tiles[j].extra = TILE_EX_BONE_BASE_LEFT;
 			chunk.tiles[j + 1].extra = TILE_EX_BONE_BASE_RIGHT;
@@ -1017,10 +1752,10 @@ bool world_generator::add_bone(world_chunk& chunk, int i) {
 	return false;
 }
 
-bool world_generator::add_spike(world_chunk& chunk, int i) {
+bool world_generator::add_spike(chunk_generation& chunk, int i, seeded_random& random) const {
 	int x = i % world_chunk::tiles_per_row;
 	int y = i / world_chunk::tiles_per_row;
-	if (y > 5 && x % 2 != 0 && chunk.tiles[i].type == TILE_WALL && chunk.tiles[i + 1].type == TILE_WALL && ne::random_chance(0.6f)) {
+	if (y > 5 && x % 2 != 0 && i + 1 < world_chunk::total_tiles && chunk.tiles[i].type == TILE_WALL && chunk.tiles[i + 1].type == TILE_WALL && random.chance(0.6f)) {
 		int j = i - world_chunk::tiles_per_row;
 		int k = j - world_chunk::tiles_per_row;
 		int l = k - world_chunk::tiles_per_row;
@@ -1029,77 +1764,77 @@ bool world_generator::add_spike(world_chunk& chunk, int i) {
 		if (!left || !right) {
 			return false;
 		}
-		spike_object spike;
-		spike.transform.position.xy = {
-			(float)x * (float)world_chunk::tile_pixel_size,
-			((float)y - 4.5f) * (float)world_chunk::tile_pixel_size
-		};
-		spike.transform.position.x += chunk.transform.position.x;
-		spike.transform.position.y += chunk.transform.position.y;
-		world->spikes.push_back(spike);
+		placed_object spike;
+		spike.type = PLACED_SPIKE;
+		spike.position = world_chunk::origin(chunk.index);
+		spike.position.x += (float)x * (float)world_chunk::tile_pixel_size;
+		spike.position.y += ((float)y - 4.5f) * (float)world_chunk::tile_pixel_size;
+		chunk.objects.push_back(spike);
 		return true;
 	}
 	return false;
 }
 
-void world_generator::normal(const ne::vector2i& index) {
-	int tile_x = index.x * world_chunk::tiles_per_row;
-	int tile_y = index.y * world_chunk::tiles_per_column;
-	size_t chunk_index = index.y * game_world::chunks_per_row + index.x;
-	if (chunk_index >= world->total_chunks) {
-		return;
-	}
-	world_chunk& chunk = world->chunks[chunk_index];
+void world_generator::fill_noise(const ne::vector2i& index, chunk_noise& fields) const {
+	const int width = world_chunk::tiles_per_row;
+	const int height = world_chunk::tiles_per_column;
+	const int count = world_chunk::total_tiles;
+	int tile_x = index.x * width;
+	int tile_y = index.y * height;
+	// The cave and floor fields only differ in persistence, so their octaves are sampled once.
+	noise.octave_samples(fields.octaves, width, height, 4, 0.05f, tile_x, tile_y);
+	world_noise::combine_octaves(fields.cave, fields.octaves, count, 4, 0.35f);
+	world_noise::combine_octaves(fields.floor, fields.octaves, count, 4, 0.6f);
+	noise.octave_block(fields.pillars, width, height, 4, 0.5f, 0.05f, -128000 + tile_x, -128000 + tile_y);
+	noise.octave_block(fields.slime, width, height, 5, 0.7f, 0.05f, -64000 + tile_x, -64000 + tile_y);
+}
+
+void world_generator::normal(chunk_generation& chunk) const {
+	ne::vector2f origin = world_chunk::origin(chunk.index);
+	seeded_random random(seed, chunk.index);
+	std::unique_ptr<chunk_noise> fields = std::make_unique<chunk_noise>();
+	fill_noise(chunk.index, *fields);
 	for (int i = 0; i < world_chunk::total_tiles; i++) {
-		int x = i % world_chunk::tiles_per_row;
-		int y = i / world_chunk::tiles_per_row;
-		float noise1 = ne::octave_noise(4.0f, 0.35f, 0.05f, tile_x + x, tile_y + y);
 		int type = TILE_WALL;
-		if (noise1 > 0.0f) {
+		if (fields->cave[i] > 0.0f) {
 			type = TILE_BG_TOP;
-			float noise2 = ne::octave_noise(4.0f, 0.6f, 0.05f, tile_x + x, tile_y + y);
-			float noise3 = ne::octave_noise(4.0f, 0.5f, 0.05f, -128000 + tile_x + x, -128000 + tile_y + y);
-			if (noise2 > 0.4f) {
+			if (fields->floor[i] > 0.4f) {
 				type = TILE_BG_BOTTOM;
 			}
-			if (noise2 > 0.35f && noise3 > 0.35f) {
+			if (fields->floor[i] > 0.35f && fields->pillars[i] > 0.35f) {
 				type = TILE_WALL;
 			}
-			if (noise2 > 0.31f) { 
-				float noise4 = ne::octave_noise(5.0f, 0.7f, 0.05f, -64000 + tile_x + x, -64000 + tile_y + y);
-				if (noise4 > 0.45f) {
-					type = TILE_SLIME;
-				}
+			if (fields->floor[i] > 0.31f && fields->slime[i] > 0.45f) {
+				type = TILE_SLIME;
 			}
 		}
 		if (type == TILE_SLIME) {
 			chunk.tiles[i].health = 4;
-			chunk.slime_tiles.push_back({ i });
+			chunk.slime_tiles.push_back(i);
 		}
 		chunk.tiles[i].type = type;
 	}
 	for (int i = 0; i < world_chunk::total_tiles; i++) {
 		int x = i % world_chunk::tiles_per_row;
 		int y = i / world_chunk::tiles_per_row;
-		bool added = add_bone(chunk, i);
+		bool added = add_bone(chunk, i, random);
 		if (!added) {
-			added = add_spike(chunk, i);
+			added = add_spike(chunk, i, random);
 		}
 		if (!added) {
 			if (chunk.tiles[i].type != TILE_WALL && chunk.tiles[i].type != TILE_SLIME) {
-				if (ne::random_chance(0.003f)) {
-					world->pimple_enemies.push_back({});
-					world->pimple_enemies.back().transform.position.xy = chunk.transform.position.xy;
-					world->pimple_enemies.back().transform.position.x += (float)x * (float)world_chunk::tile_pixel_size;
-					world->pimple_enemies.back().transform.position.y += (float)y * (float)world_chunk::tile_pixel_size;
-				} else if (ne::random_chance(0.005f)) {
-					world->arteries.push_back({});
-					world->arteries.back().type = ne::random_int(4);
-					world->arteries.back().transform.position.xy = chunk.transform.position.xy;
-					world->arteries.back().transform.position.x += (float)x * (float)world_chunk::tile_pixel_size;
-					world->arteries.back().transform.position.y += (float)(y - 4) * (float)world_chunk::tile_pixel_size;
+				if (random.chance(0.003f)) {
+					chunk.objects.push_back({ PLACED_PIMPLE, origin });
+					chunk.objects.back().position.x += (float)x * (float)world_chunk::tile_pixel_size;
+					chunk.objects.back().position.y += (float)y * (float)world_chunk::tile_pixel_size;
+				} else if (random.chance(0.005f)) {
+					chunk.objects.push_back({ PLACED_ARTERY, origin });
+					chunk.objects.back().variant = random.next_int(4);
+					chunk.objects.back().flipped = random.chance(0.45f);
+					chunk.objects.back().position.x += (float)x * (float)world_chunk::tile_pixel_size;
+					chunk.objects.back().position.y += (float)(y - 4) * (float)world_chunk::tile_pixel_size;
 				}
-			} else if (x > 1 && y > 3 && chunk.tiles[i].type == TILE_WALL && chunk.tiles[i + 1].type == TILE_WALL) {
+			} else if (x > 1 && y > 3 && i + 1 < world_chunk::total_tiles && chunk.tiles[i].type == TILE_WALL && chunk.tiles[i + 1].type == TILE_WALL) {
 				int j = i - world_chunk::tiles_per_row;
 				int k = j - world_chunk::tiles_per_row;
 				int l = k - world_chunk::tiles_per_row;
@@ -1110,16 +1845,14 @@ void world_generator::normal(const ne::vector2i& index) {
 				int lt1 = chunk.tiles[l].type;
 				int lt2 = chunk.tiles[l + 1].type;
 				if (jt1 != TILE_WALL && jt2 != TILE_WALL && kt1 != TILE_WALL && kt2 != TILE_WALL && lt1 != TILE_WALL && lt2 != TILE_WALL) {
-					if (ne::random_chance(0.1f)) {
-						world->zindo_bloods.push_back({});
-						world->zindo_bloods.back().transform.position.xy = chunk.transform.position.xy;
-						world->zindo_bloods.back().transform.position.x += (float)x * (float)world_chunk::tile_pixel_size;
-						world->zindo_bloods.back().transform.position.y += (float)(y - 3) * (float)world_chunk::tile_pixel_size;
-					} else if (ne::random_chance(0.2f)) {
-						world->neurons.push_back({});
-						world->neurons.back().transform.position.xy = chunk.transform.position.xy;
-						world->neurons.back().transform.position.x += (float)x * (float)world_chunk::tile_pixel_size;
-						world->neurons.back().transform.position.y += (float)(y - 4) * (float)world_chunk::tile_pixel_size;
+					if (random.chance(0.1f)) {
+						chunk.objects.push_back({ PLACED_ZINDO_BLOOD, origin });
+						chunk.objects.back().position.x += (float)x * (float)world_chunk::tile_pixel_size;
+						chunk.objects.back().position.y += (float)(y - 3) * (float)world_chunk::tile_pixel_size;
+					} else if (random.chance(0.2f)) {
+						chunk.objects.push_back({ PLACED_NEURON, origin });
+						chunk.objects.back().position.x += (float)x * (float)world_chunk::tile_pixel_size;
+						chunk.objects.back().position.y += (float)(y - 4) * (float)world_chunk::tile_pixel_size;
 					}
 				}
 			}
@@ -1127,12 +1860,7 @@ void world_generator::normal(const ne::vector2i& index) {
 	}
 }
 
-void world_generator::border(const ne::vector2i& index) {
-	size_t chunk_index = index.y * game_world::chunks_per_row + index.x;
-	if (chunk_index >= world->total_chunks) {
-		return;
-	}
-	world_chunk& chunk = world->chunks[chunk_index];
+void world_generator::border(chunk_generation& chunk) const {
 	for (int i = 0; i < world_chunk::total_tiles; i++) {
 		chunk.tiles[i].type = TILE_WALL;
 		chunk.tiles[i].health = 127;